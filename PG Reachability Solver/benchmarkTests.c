@@ -1,4 +1,5 @@
 #include "gameGenerator.h"
+#include "gameBinary.h"
 #include "pgSolver1.h"
 #include "pgSolver2.h"
 #include "strategyImprovement.h"
@@ -7,26 +8,15 @@
  * @brief Writes the graph info to the xlsx file and determines the maximum priority in the game
  * 
  * @param G 
- * @param n 
  * @param tCount 
  * @param worksheet 
  * @return int the maximum priority in the graph
  */
-int graphInfo(long **G, long n, int tCount, lxw_worksheet *worksheet) {
-    worksheet_write_number(worksheet, tCount+2, 2, n, NULL);
+int graphInfo(game *G, int tCount, lxw_worksheet *worksheet) {
+    worksheet_write_number(worksheet, tCount+2, 2, G->n, NULL);
 
-    long eCount = 0; //number of edges
-    long maxP = 0; //maximum priority
-
-    for(int i=0; i<n; i++) {
-        if(G[i][1] > maxP) {
-            maxP = G[i][1];
-        }
-
-        for(int j=2; G[i][j] >= 0; j++) {
-            eCount++;
-        }
-    }
+    long eCount = G->m; //number of edges
+    long maxP = maxOmega(G); //maximum priority
 
     worksheet_write_number(worksheet, tCount+2, 3, maxP, NULL);
     worksheet_write_number(worksheet, tCount+2, 4, eCount, NULL);
@@ -35,68 +25,92 @@ int graphInfo(long **G, long n, int tCount, lxw_worksheet *worksheet) {
 }
 
 /**
- * @brief performs the benchmarking test for a given test file
+ * @brief loads a test game, using the binary version created by gm2bin (fileName.bin) when it is present, valid and
+ * made from the current version of the text file
  * 
  * @param fileName the path and name of the test file
  * @param nMax the maximum number of vertices in a test graph
  * @param pMax the maximum priority of any vertex in a test graph
- * @return int 1 if the test was successful
+ * @return game* the game, NULL if it does not meet the criteria of the benchmark
  */
-int oneFileBenchmark(char *fileName, long nMax, long pMax, int tCount, lxw_workbook *workbook, lxw_worksheet *worksheet) {
-    FILE *fp;
-    fp = fopen(fileName, "r");
-
+game *loadGame(char *fileName, long nMax, long pMax) {
+    game *G = NULL;
+    char *binName = (char *) malloc((strlen(fileName) + strlen(BINARY_GAME_EXTENSION) + 1) * sizeof(char));
+    verify_alloc(binName);
+    strcpy(binName, fileName);
+    strcat(binName, BINARY_GAME_EXTENSION);
+
+    if(access(binName, R_OK) == 0) {
+        G = loadBinaryGame(binName, fileName, nMax, pMax);
+    }
+    free(binName);
 
-    if(fp == NULL) {
-        printf("Error while opening file\n");
-        return 0;
+    if(G == NULL) {
+        G = createPG(fileName, nMax, pMax);
     }
 
-    long n;
-    long **G = createPG(fp, &n, nMax, pMax);
-    long **GC; //graph copy
+    return G;
+}
 
-    if(n <= 0) {
-        fclose(fp);
+/**
+ * @brief performs the benchmarking test for a given test file
+ * 
+ * @param fileName the path and name of the test file
+ * @param nMax the maximum number of vertices in a test graph
+ * @param pMax the maximum priority of any vertex in a test graph
+ * @return int 1 if the test was successful
+ */
+int oneFileBenchmark(char *fileName, long nMax, long pMax, int tCount, lxw_worksheet *worksheet) {
+    game *G = loadGame(fileName, nMax, pMax);
+
+    if(G == NULL) {
         return 0;
     }
 
+    long n = G->n;
+
     printf("%s\n", fileName);
 
-    int maxP = graphInfo(G, n, tCount, worksheet); //maximum priority in the graph
+    graphInfo(G, tCount, worksheet);
+
+    //the solvers only depend on the order and parity of the priorities
+    int maxP = compressPriorities(G); //maximum priority in the graph after compression
 
     int verify = 1;
 
     time_t t1, t2, t3, start, end;    
     
     int *W1, *W2, *W3;
+    improvementStats s2, s3; //the work of strategy improvement in pgSolver2 and pgSolver3
+    improvementStats none = {{0, 0, 0}, 0, 0, 0};
 
-    GC = duplicateGraph(G, n);
+    //the solvers do not change G, so all of them use the same game
+    improvementCounters = none;
     time(&start);
-    W2 = pgSolver2(GC, n);
+    W2 = pgSolver2(G);
     time(&end);
     t2 = end - start;
-    freeGraph(n, GC);
+    s2 = improvementCounters;
     
     worksheet_write_number(worksheet, tCount+2, 6, t2, NULL);
 
-    GC = duplicateGraph(G, n);
+    improvementCounters = none;
     time(&start);
-    W3 = pgSolver3(GC, n);
+    W3 = pgSolver3(G);
     time(&end);
     t3 = end - start;
-    freeGraph(n, GC);
+    s3 = improvementCounters;
 
     worksheet_write_number(worksheet, tCount+2, 7, t3, NULL);
 
-    if(maxP <= 1 || (n <= 300 && maxP <= 4)) {
-        //for higher values, pgSolver1 would take an incredibly long time 
-        GC = duplicateGraph(G, n);
+    //the energy backend does not need the 4n^2 N rounds of the value iteration
+    int runSolver1 = (options.mpgBackend == MPG_ENERGY || maxP <= 1 || (n <= 300 && maxP <= 4)) && mpgWeightsFit(n, maxP);
+    if(runSolver1) {
+        //for higher values, pgSolver1 would take an incredibly long time, or its weights would not fit in mpgWeight
         time(&start);
-        W1 = pgSolver1(GC, n);
+        W1 = pgSolver1(G);
         time(&end);
         t1 = end - start;
-        freeGraph(n, GC);
         worksheet_write_number(worksheet, tCount+2, 5, t1, NULL);
     } else {
         t1 = 0;
@@ -118,15 +132,17 @@ int oneFileBenchmark(char *fileName, long nMax, long pMax, int tCount, lxw_workb
     
 
     printf("PGSolver1: %lds; PGSolver2: %lds; PGSolver3: %lds\n", t1, t2, t3);
+    printf("Strategy improvement rounds (P1/P2/inner), switches, evaluations: PGSolver2: %ld/%ld/%ld, %ld, %ld; "
+           "PGSolver3: %ld/%ld/%ld, %ld, %ld\n", s2.rounds[1], s2.rounds[2], s2.innerRounds, s2.switches,
+           s2.evaluations, s3.rounds[1], s3.rounds[2], s3.innerRounds, s3.switches, s3.evaluations);
 
-    if(maxP <= 1 || (n <= 300 && maxP <= 4))  {
+    if(runSolver1)  {
         free(W1);
     }
     free(W2);
     free(W3);
 
-    freeGraph(n, G);
-    fclose(fp);
+    freeGame(G);
 
     return 1;
 }
@@ -139,7 +155,7 @@ int oneFileBenchmark(char *fileName, long nMax, long pMax, int tCount, lxw_workb
  * @param pMax the maximum priority of any given vertex in a test graph
  * @param tMax the maximum number of tests to be performed
  */
-int benchmarkTestSet(char *directory, long nMax, long pMax, long tMax, int tCount, lxw_workbook *workbook, lxw_worksheet *worksheet) {
+int benchmarkTestSet(char *directory, long nMax, long pMax, long tMax, int tCount, lxw_worksheet *worksheet) {
     char *location = (char *) malloc(300 * sizeof(char)); //stores the full path to the directory with the tests
 
     //get current location
@@ -180,11 +196,15 @@ int benchmarkTestSet(char *directory, long nMax, long pMax, long tMax, int tCoun
                 //we make sure we only look at actual files
                 continue;
             }
+            if(hasSuffix(de->d_name, BINARY_GAME_EXTENSION)) {
+                //binary versions are loaded together with their text file
+                continue;
+            }
             fileName = (char *) malloc((strlen(location) + strlen(de->d_name) + 2) * sizeof(char));
             strcpy(fileName, location);
             strcat(fileName, "/");
             strcat(fileName, de->d_name);
-            if(oneFileBenchmark(fileName, nMax, pMax, tCount, workbook, worksheet)) {
+            if(oneFileBenchmark(fileName, nMax, pMax, tCount, worksheet)) {
                 //write information about test to file
                 worksheet_write_string(worksheet, tCount+2, 0, directory, NULL);
                 worksheet_write_string(worksheet, tCount+2, 1, de->d_name, NULL);
@@ -2,6 +2,6 @@
 #define BENCHMARKTESTS_H_INCLUDED
 #include "utilities.h"
 
-int benchmarkTestSet(char *directory, long nMax, long pMax, long tMax, int tCount, lxw_workbook *workbook, lxw_worksheet *worksheet);
+int benchmarkTestSet(char *directory, long nMax, long pMax, long tMax, int tCount, lxw_worksheet *worksheet);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,287 @@
+#include <sys/time.h>
+
+#include "utilities.h"
+#include "gameGenerator.h"
+#include "pgSolver1.h"
+#include "pgSolver2.h"
+
+/**
+ * @brief returns the current time in seconds
+ *
+ * @return double seconds since the epoch
+ */
+double now() {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec + t.tv_usec * 1e-6;
+}
+
+/**
+ * @brief the search for k-obsolete edges of pgObsolete as it was before the kernel was rewritten:
+ * two fresh arrays per round and calls to epsilon and phi for every edge
+ *
+ * @param k the maximum length of the cycle
+ * @param G the game
+ * @return edge* the array of k-obsolete edges
+ */
+edge *referencePgObsolete(long k, game *G) {
+    long n = G->n;
+    edgeList L = {NULL, 0, 0};
+    int inf = INT_MAX - 1; //infinity
+    int max;
+    long u;
+    int hasOutgoingEdges;
+
+    for(long v=0; v < n; v++) {
+        long *eta = (long *) malloc (n * sizeof(long));
+        verify_alloc(eta);
+
+        for(long w = 0; w < n; w++) {
+            if(w == v) {
+                eta[w] = 0;
+            }
+            else eta[w] = inf;
+        }
+
+        for(long i = 1; i < k; i++) {
+            long *nextEta = (long *) malloc (n * sizeof(long));
+            verify_alloc(nextEta);
+
+            for(long w = 0; w < n; w++) {
+                if(w == v) {
+                    nextEta[w] = 0;
+                    continue;
+                }
+
+                hasOutgoingEdges = 0;
+                for (uint32_t j = G->offsets[w]; j < G->offsets[w+1]; j++) {
+                    if(!edgeDeleted(G, j)) {
+                        u = G->targets[j];
+                        if(hasOutgoingEdges == 0) {
+                            hasOutgoingEdges = 1;
+                            max = epsilon(G, w) * phi(eta[u], v, inf, G);
+                        } else if(epsilon(G, w) * phi(eta[u], v, inf, G) > max) {
+                            max = epsilon(G, w) * phi(eta[u], v, inf, G);
+                        }
+                    }
+                }
+
+                if(!hasOutgoingEdges) {
+                    nextEta[w] = inf;
+                    continue;
+                }
+
+                if((long) G->priority[w] > epsilon(G, w) * phi(max, v, inf, G)) {
+                    nextEta[w] = G->priority[w];
+                }
+                else nextEta[w] = epsilon(G, w) * phi(max, v, inf, G);
+            }
+
+            free(eta);
+            eta = nextEta;
+        }
+        for(uint32_t i = G->offsets[v]; i < G->offsets[v+1]; i++) {
+            if(!edgeDeleted(G, i)) {
+                u = G->targets[i];
+                if(eta[u] > G->priority[v]) {
+                    max = eta[u];
+                }
+                else max = G->priority[v];
+                if(eta[u] != inf && max % 2 != G->owner[v] % 2) {
+                    addEdge(&L, v, u);
+                }
+            }
+        }
+        free(eta);
+    }
+
+    return mergeEdgeLists(&L, 1);
+}
+
+/**
+ * @brief the search for k-obsolete edges of mpgObsolete as it was before the kernel was rewritten
+ *
+ * @param k the maximum length of the cycle
+ * @param G the game
+ * @param mu the array of edge weights
+ * @return edge* the array of k-obsolete edges
+ */
+edge *referenceMpgObsolete(long k, game *G, mpgWeight *mu) {
+    long n = G->n;
+    edgeList L = {NULL, 0, 0};
+    int e;
+    mpgWeight inf = MPG_INF; //infinity
+    mpgWeight max;
+    long u;
+    int hasOutgoingEdges;
+
+    for(long v=0; v < n; v++) {
+        e = epsilon(G, v);
+        mpgWeight *eta = (mpgWeight *) malloc (n * sizeof(mpgWeight));
+        verify_alloc(eta);
+
+        for(long w = 0; w < n; w++) {
+            if(w == v) {
+                eta[w] = 0;
+            }
+            else eta[w] = e * inf;
+        }
+
+        for(long i = 1; i < k; i++) {
+            mpgWeight *nextEta = (mpgWeight *) malloc (n * sizeof(mpgWeight));
+            verify_alloc(nextEta);
+
+            for(long w = 0; w < n; w++) {
+                if(w == v) {
+                    nextEta[w] = 0;
+                    continue;
+                }
+
+                hasOutgoingEdges = 0;
+                for (uint32_t j = G->offsets[w]; j < G->offsets[w+1]; j++) {
+                    if(!edgeDeleted(G, j)) {
+                        u = G->targets[j];
+                        if(hasOutgoingEdges == 0) {
+                            hasOutgoingEdges = 1;
+                            max = epsilon(G, w) * eta[u];
+                        } else if(epsilon(G, w) * eta[u] > max) {
+                            max = epsilon(G, w) * eta[u];
+                        }
+                    }
+                }
+
+                if(!hasOutgoingEdges) {
+                    nextEta[w] = e * inf;
+                    continue;
+                }
+
+                if(max != -inf && max != inf) {
+                    nextEta[w] = epsilon(G, w) * max + mu[w];
+                }
+                else nextEta[w] = epsilon(G, w) * max;
+            }
+
+            free(eta);
+            eta = nextEta;
+        }
+        for(uint32_t i = G->offsets[v]; i < G->offsets[v+1]; i++) {
+            if(!edgeDeleted(G, i)) {
+                u = G->targets[i];
+                if(e * eta[u] < -e * mu[v]) {
+                    addEdge(&L, v, u);
+                }
+            }
+        }
+        free(eta);
+    }
+
+    return mergeEdgeLists(&L, 1);
+}
+
+/**
+ * @brief orders edges by source, then by target; used with qsort
+ */
+int compareEdges(const void *a, const void *b) {
+    const edge *x = (const edge *) a;
+    const edge *y = (const edge *) b;
+
+    if(x->v1 != y->v1) {
+        return x->v1 < y->v1 ? -1 : 1;
+    }
+    if(x->v2 != y->v2) {
+        return x->v2 < y->v2 ? -1 : 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief returns 1 if the two arrays contain the same edges, in any order. Both arrays are sorted
+ *
+ * @param F an array of edges ending with (-1, -1)
+ * @param H an array of edges ending with (-1, -1)
+ * @return int 1 if the arrays are equal as multisets
+ */
+int sameEdges(edge *F, edge *H) {
+    long fn = 0, hn = 0;
+
+    while(F[fn].v1 != (unsigned long) -1) {
+        fn++;
+    }
+    while(H[hn].v1 != (unsigned long) -1) {
+        hn++;
+    }
+    if(fn != hn) {
+        return 0;
+    }
+    qsort(F, fn, sizeof(edge), compareEdges);
+    qsort(H, hn, sizeof(edge), compareEdges);
+
+    return memcmp(F, H, fn * sizeof(edge)) == 0;
+}
+
+/**
+ * @brief compares the obsolete edge kernels of pgObsolete and mpgObsolete with the loops they replaced on the given
+ * games, and checks that both find the same edges
+ */
+int main(int argc, char **argv) {
+    long k = 0; //the maximum length of the cycle, n if 0
+    int opt, same, failed = 0;
+    double t1, t2, t3;
+    edge *F, *H;
+
+    while((opt = getopt(argc, argv, "k:t:")) != -1) {
+        if(opt == 'k') {
+            k = atol(optarg);
+        }
+        else if(opt == 't') {
+            options.threads = atoi(optarg) < 1 ? 1 : atoi(optarg);
+        }
+        else {
+            printf("Usage: %s [-k length] [-t threads] file.gm ...\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if(optind >= argc) {
+        printf("Usage: %s [-k length] [-t threads] file.gm ...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    for(int i = optind; i < argc; i++) {
+        game *G = createPG(argv[i], UINT32_MAX, UINT32_MAX);
+        if(G == NULL) {
+            printf("%s: not a parity game without sinks, skipped\n", argv[i]);
+            continue;
+        }
+        long kG = (k > 0) ? k : (long) G->n;
+        int M = maxOmega(G);
+        mpgWeight *mu = getMu(G, M);
+
+        t1 = now();
+        F = referencePgObsolete(kG, G);
+        t2 = now();
+        H = pgObsolete(kG, G, NULL);
+        t3 = now();
+        printf("%s: n=%u m=%u k=%ld\n", argv[i], G->n, G->m, kG);
+        same = sameEdges(F, H);
+        printf("  pgObsolete:  %.3fs -> %.3fs (%.2fx)%s\n", t2 - t1, t3 - t2, (t2 - t1) / (t3 - t2), same ? "" : " MISMATCH");
+        failed = failed || !same;
+        free(F);
+        free(H);
+
+        t1 = now();
+        F = referenceMpgObsolete(kG, G, mu);
+        t2 = now();
+        H = mpgObsolete(kG, G, mu, NULL);
+        t3 = now();
+        same = sameEdges(F, H);
+        printf("  mpgObsolete: %.3fs -> %.3fs (%.2fx)%s\n", t2 - t1, t3 - t2, (t2 - t1) / (t3 - t2), same ? "" : " MISMATCH");
+        failed = failed || !same;
+        free(F);
+        free(H);
+
+        free(mu);
+        freeGame(G);
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
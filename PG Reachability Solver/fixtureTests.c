@@ -0,0 +1,325 @@
+#include "utilities.h"
+#include "gameGenerator.h"
+#include "gameBinary.h"
+#include "pgSolver1.h"
+#include "pgSolver2.h"
+#include "strategyImprovement.h"
+
+/**
+ * @brief a setting of the solver options the fixture games are solved with
+ */
+typedef struct optionSet {
+    const char *name; //shown in the output
+    solverOptions options; //the options
+} optionSet;
+
+//the games of the fixture directory that are parity games without sinks
+static const char *accepted[] = {"small.gm", "parallel-edges.gm", "random-300.gm"};
+
+//the games the parser has to reject
+static const char *rejected[] = {"sink.gm", "duplicate-vertex.gm", "missing-vertex.gm", "edge-out-of-range.gm",
+    "bad-owner.gm", "truncated.gm.gz"};
+
+static int failed = 0; //1 once a check failed
+
+/**
+ * @brief prints the result of one check and remembers a failure
+ *
+ * @param passed 1 if the check passed
+ * @param what what was checked
+ */
+void check(int passed, const char *what) {
+    printf("  %-60s %s\n", what, passed ? "ok" : "FAILED");
+    failed = failed || !passed;
+}
+
+/**
+ * @brief returns the path of a file in a directory
+ *
+ * @param directory the directory
+ * @param name the name of the file
+ * @return char* the path, to be freed by the caller
+ */
+char *joinPath(const char *directory, const char *name) {
+    char *path = (char *) malloc(strlen(directory) + strlen(name) + 2);
+    verify_alloc(path);
+    sprintf(path, "%s/%s", directory, name);
+    return path;
+}
+
+/**
+ * @brief reads a game from a file in the fixture directory
+ *
+ * @param directory the fixture directory
+ * @param name the name of the file
+ * @return game* the game, NULL if it was rejected
+ */
+game *loadFixture(const char *directory, const char *name) {
+    char *path = joinPath(directory, name);
+    game *G = createPG(path, UINT32_MAX, UINT32_MAX);
+    free(path);
+    return G;
+}
+
+/**
+ * @brief returns 1 if two games have the same vertices and edges
+ */
+int sameGame(const game *G, const game *H) {
+    if(G == NULL || H == NULL || G->n != H->n || G->m != H->m) {
+        return 0;
+    }
+    return memcmp(G->owner, H->owner, G->n * sizeof(uint8_t)) == 0
+        && memcmp(G->priority, H->priority, G->n * sizeof(uint32_t)) == 0
+        && memcmp(G->offsets, H->offsets, (G->n + 1) * sizeof(uint32_t)) == 0
+        && memcmp(G->targets, H->targets, G->m * sizeof(uint32_t)) == 0;
+}
+
+/**
+ * @brief copies a file
+ *
+ * @param from the path of the file
+ * @param to the path of the copy
+ * @return int 1 on success
+ */
+int copyFile(const char *from, const char *to) {
+    char buffer[4096];
+    size_t size;
+    int ok = 1;
+    FILE *in = fopen(from, "rb");
+    if(in == NULL) {
+        return 0;
+    }
+    FILE *out = fopen(to, "wb");
+    if(out == NULL) {
+        fclose(in);
+        return 0;
+    }
+    while((size = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+        ok = ok && fwrite(buffer, 1, size, out) == size;
+    }
+    ok = ok && !ferror(in);
+    fclose(in);
+    return fclose(out) == 0 && ok;
+}
+
+/**
+ * @brief overwrites bytes of a file
+ *
+ * @param fileName the path of the file
+ * @param position where the bytes start
+ * @param data the new bytes
+ * @param size the number of bytes
+ * @return int 1 on success
+ */
+int patchFile(const char *fileName, long position, const void *data, size_t size) {
+    FILE *fp = fopen(fileName, "r+b");
+    if(fp == NULL) {
+        return 0;
+    }
+    int ok = fseek(fp, position, SEEK_SET) == 0 && fwrite(data, 1, size, fp) == size;
+    return fclose(fp) == 0 && ok;
+}
+
+/**
+ * @brief checks that the parser accepts the valid games, reads the text, gzip and bzip2 forms of a game the same way
+ * and rejects the broken games
+ *
+ * @param directory the fixture directory
+ */
+void checkParser(const char *directory) {
+    game *G;
+    char what[100];
+
+    printf("parser\n");
+    G = loadFixture(directory, "random-300.gm");
+    game *Z = loadFixture(directory, "random-300.gm.gz");
+    game *B = loadFixture(directory, "random-300.gm.bz2");
+    check(sameGame(G, Z), "random-300.gm.gz is read as the same game");
+    check(sameGame(G, B), "random-300.gm.bz2 is read as the same game");
+    freeGame(G);
+    freeGame(Z);
+    freeGame(B);
+
+    for(size_t i = 0; i < sizeof(accepted) / sizeof(accepted[0]); i++) {
+        G = loadFixture(directory, accepted[i]);
+        snprintf(what, sizeof(what), "%s is accepted", accepted[i]);
+        check(G != NULL, what);
+        freeGame(G);
+    }
+    for(size_t i = 0; i < sizeof(rejected) / sizeof(rejected[0]); i++) {
+        G = loadFixture(directory, rejected[i]);
+        snprintf(what, sizeof(what), "%s is rejected", rejected[i]);
+        check(G == NULL, what);
+        freeGame(G);
+    }
+}
+
+/**
+ * @brief checks that a binary game file is only used while it is intact and its text file has not changed. The files
+ * are written to a temporary directory, so the fixture directory stays as it is
+ *
+ * @param directory the fixture directory
+ */
+void checkBinary(const char *directory) {
+    char temporary[] = "/tmp/fixtureTestsXXXXXX";
+    long owner = (sizeof(binaryGameHeader) + 7) & ~7L; //the position of owner[0], see binaryLayout
+    uint8_t badOwner = 7;
+    uint32_t otherOrder = 0x04030201;
+
+    printf("binary files\n");
+    if(mkdtemp(temporary) == NULL) {
+        check(0, "a temporary directory is created");
+        return;
+    }
+    char *source = joinPath(directory, "random-300.gm");
+    char *text = joinPath(temporary, "random-300.gm");
+    char *binary = joinPath(temporary, "random-300.gm" BINARY_GAME_EXTENSION);
+    game *G = createPG(source, UINT32_MAX, UINT32_MAX);
+    game *H;
+    check(G != NULL && copyFile(source, text) && writeBinaryGame(G, binary, text), "random-300.gm is converted");
+    if(G == NULL) {
+        free(source);
+        free(text);
+        free(binary);
+        rmdir(temporary);
+        return;
+    }
+
+    H = loadBinaryGame(binary, text, UINT32_MAX, UINT32_MAX);
+    check(sameGame(G, H), "the binary file is read as the same game");
+    freeGame(H);
+
+    H = loadBinaryGame(binary, text, G->n - 1, UINT32_MAX);
+    check(H == NULL, "a game with too many vertices is skipped");
+    freeGame(H);
+
+    check(patchFile(binary, owner, &badOwner, sizeof(badOwner)), "an owner is overwritten");
+    H = loadBinaryGame(binary, text, UINT32_MAX, UINT32_MAX);
+    check(H == NULL, "a damaged binary file is not used");
+    freeGame(H);
+
+    check(writeBinaryGame(G, binary, text) && truncate(binary, owner + G->n) == 0, "the binary file is truncated");
+    H = loadBinaryGame(binary, text, UINT32_MAX, UINT32_MAX);
+    check(H == NULL, "a truncated binary file is not used");
+    freeGame(H);
+
+    check(writeBinaryGame(G, binary, text)
+        && patchFile(binary, offsetof(binaryGameHeader, byteOrder), &otherOrder, sizeof(otherOrder)),
+        "the byte order is changed");
+    H = loadBinaryGame(binary, text, UINT32_MAX, UINT32_MAX);
+    check(H == NULL, "a binary file of another byte order is not used");
+    freeGame(H);
+
+    check(writeBinaryGame(G, binary, text), "random-300.gm is converted again");
+    FILE *fp = fopen(text, "ab");
+    check(fp != NULL && fputs("\n", fp) >= 0 && fclose(fp) == 0, "the text file is changed");
+    H = loadBinaryGame(binary, text, UINT32_MAX, UINT32_MAX);
+    check(H == NULL, "an out of date binary file is not used");
+    freeGame(H);
+
+    freeGame(G);
+    unlink(binary);
+    unlink(text);
+    rmdir(temporary);
+    free(source);
+    free(text);
+    free(binary);
+}
+
+/**
+ * @brief solves the accepted games with every solver under each option set and checks that all of them find the
+ * winners of the default options
+ *
+ * @param directory the fixture directory
+ */
+void checkSolvers(const char *directory) {
+    solverOptions defaults = options;
+    optionSet sets[] = {
+        {"defaults", defaults},
+        {"4 threads, parallel SCCs", defaults},
+        {"adaptive k", defaults},
+        {"energy backend", defaults},
+        {"4 threads, parallel sweeps", defaults},
+        {"all first", defaults},
+        {"single best", defaults},
+        {"random edge", defaults},
+        {"random order", defaults},
+        {"restricted best", defaults},
+        {"4 threads, parallel strategy improvement", defaults},
+        {"random facet", defaults},
+        {"4 threads, single best", defaults},
+        {"4 threads, random edge", defaults},
+        {"4 threads, random order", defaults}
+    };
+    sets[1].options.threads = 4;
+    sets[1].options.parallelScc = 1;
+    sets[1].options.sccThreshold = 1;
+    sets[2].options.adaptiveK = 2;
+    sets[3].options.mpgBackend = MPG_ENERGY;
+    sets[4].options.threads = 4;
+    sets[4].options.sweepThreshold = 1;
+    sets[5].options.switchPolicy = SWITCH_ALL_FIRST;
+    sets[6].options.switchPolicy = SWITCH_SINGLE_BEST;
+    sets[7].options.switchPolicy = SWITCH_RANDOM_EDGE;
+    sets[8].options.switchPolicy = SWITCH_RANDOM_ORDER;
+    sets[9].options.switchPolicy = SWITCH_RESTRICTED_BEST;
+    sets[10].options.threads = 4;
+    sets[10].options.improvementThreshold = 1;
+    sets[11].options.switchPolicy = SWITCH_RANDOM_FACET;
+    sets[12].options.threads = 4;
+    sets[12].options.improvementThreshold = 1;
+    sets[12].options.switchPolicy = SWITCH_SINGLE_BEST;
+    sets[13].options.threads = 4;
+    sets[13].options.improvementThreshold = 1;
+    sets[13].options.switchPolicy = SWITCH_RANDOM_EDGE;
+    sets[14].options.threads = 4;
+    sets[14].options.improvementThreshold = 1;
+    sets[14].options.switchPolicy = SWITCH_RANDOM_ORDER;
+
+    for(size_t i = 0; i < sizeof(accepted) / sizeof(accepted[0]); i++) {
+        game *G = loadFixture(directory, accepted[i]);
+        if(G == NULL) {
+            continue; //reported by checkParser
+        }
+        printf("%s\n", accepted[i]);
+        int maxP = compressPriorities(G);
+        options = defaults;
+        int *W = pgSolver2(G);
+
+        for(size_t s = 0; s < sizeof(sets) / sizeof(sets[0]); s++) {
+            options = sets[s].options;
+            //the same choice as in oneFileBenchmark
+            int runSolver1 = (options.mpgBackend == MPG_ENERGY || maxP <= 1 || (G->n <= 300 && maxP <= 4))
+                && mpgWeightsFit(G->n, maxP);
+            int *W1 = runSolver1 ? pgSolver1(G) : NULL;
+            int *W2 = pgSolver2(G);
+            int *W3 = pgSolver3(G);
+            int same = 1;
+            for(uint32_t v = 0; v < G->n; v++) {
+                same = same && W2[v] == W[v] && W3[v] == W[v] && (W1 == NULL || W1[v] == W[v]);
+            }
+            check(same, sets[s].name);
+            free(W1);
+            free(W2);
+            free(W3);
+        }
+        options = defaults;
+        free(W);
+        freeGame(G);
+    }
+}
+
+/**
+ * @brief reads the games of the fixture directory and checks the program on them
+ */
+int main(int argc, char **argv) {
+    if(argc != 2) {
+        printf("Usage: %s fixture-directory\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    checkParser(argv[1]);
+    checkBinary(argv[1]);
+    checkSolvers(argv[1]);
+    printf(failed ? "FAILED\n" : "all checks passed\n");
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,228 @@
+#include "gameBinary.h"
+
+/**
+ * @brief rounds x up to a multiple of 8
+ *
+ * @param x
+ * @return size_t
+ */
+static size_t align8(size_t x) {
+    return (x + 7) & ~(size_t) 7;
+}
+
+/**
+ * @brief computes where each section of a binary game file starts
+ *
+ * @param n number of vertices
+ * @param m number of edges
+ * @param sections sections[0..3] - offsets of owner, priority, offsets and targets; sections[4] - size of the file
+ */
+static void binaryLayout(uint32_t n, uint32_t m, size_t *sections) {
+    sections[0] = align8(sizeof(binaryGameHeader));
+    sections[1] = sections[0] + align8((size_t) n * sizeof(uint8_t));
+    sections[2] = sections[1] + align8((size_t) n * sizeof(uint32_t));
+    sections[3] = sections[2] + align8(((size_t) n + 1) * sizeof(uint32_t));
+    sections[4] = sections[3] + align8((size_t) m * sizeof(uint32_t));
+}
+
+/**
+ * @brief writes one section of a binary game file, followed by the padding up to the next section
+ *
+ * @param fp the binary game file
+ * @param data the section
+ * @param size size of the section in bytes
+ * @return int 1 on success
+ */
+static int writeSection(FILE *fp, const void *data, size_t size) {
+    static const char padding[8] = {0};
+
+    if(size > 0 && fwrite(data, 1, size, fp) != size) {
+        return 0;
+    }
+    return fwrite(padding, 1, align8(size) - size, fp) == align8(size) - size;
+}
+
+/**
+ * @brief returns the modification time of a file in nanoseconds, which is stored with a binary game to recognise a
+ * text file that changed after it was converted
+ *
+ * @param st the status of the file
+ * @return int64_t
+ */
+static int64_t modificationTime(const struct stat *st) {
+    return (int64_t) st->st_mtim.tv_sec * 1000000000 + st->st_mtim.tv_nsec;
+}
+
+/**
+ * @brief stores the game in the binary game format. Removed edges are not written
+ *
+ * @param G the game
+ * @param fileName the path of the binary file
+ * @param sourceName the path of the text file the game was read from
+ * @return int 1 on success
+ */
+int writeBinaryGame(game *G, char *fileName, char *sourceName) {
+    binaryGameHeader h;
+    struct stat source;
+    uint32_t *offsets, *targets;
+    uint32_t v, e, m = 0;
+    int ok;
+
+    if(stat(sourceName, &source) != 0) {
+        return 0;
+    }
+
+    //leave the removed edges out
+    offsets = (uint32_t *) malloc((G->n + 1) * sizeof(uint32_t));
+    targets = (uint32_t *) malloc((G->m + 1) * sizeof(uint32_t));
+    verify_alloc(offsets);
+    verify_alloc(targets);
+    for(v = 0; v < G->n; v++) {
+        offsets[v] = m;
+        for(e = G->offsets[v]; e < G->offsets[v+1]; e++) {
+            if(!edgeDeleted(G, e)) {
+                targets[m] = G->targets[e];
+                m++;
+            }
+        }
+    }
+    offsets[G->n] = m;
+
+    memcpy(h.magic, BINARY_GAME_MAGIC, 4);
+    h.version = BINARY_GAME_VERSION;
+    h.byteOrder = BINARY_GAME_BYTE_ORDER;
+    h.n = G->n;
+    h.m = m;
+    h.maxPriority = maxOmega(G);
+    h.sourceSize = source.st_size;
+    h.sourceTime = modificationTime(&source);
+
+    FILE *fp = fopen(fileName, "wb");
+    if(fp == NULL) {
+        free(offsets);
+        free(targets);
+        return 0;
+    }
+
+    ok = writeSection(fp, &h, sizeof(binaryGameHeader))
+        && writeSection(fp, G->owner, G->n * sizeof(uint8_t))
+        && writeSection(fp, G->priority, G->n * sizeof(uint32_t))
+        && writeSection(fp, offsets, (G->n + 1) * sizeof(uint32_t))
+        && writeSection(fp, targets, m * sizeof(uint32_t));
+
+    if(fclose(fp) != 0) {
+        ok = 0;
+    }
+    free(offsets);
+    free(targets);
+
+    return ok;
+}
+
+/**
+ * @brief checks that the arrays of a mapped binary game describe a game the text parser would also accept: the offsets
+ * start at 0, grow with every vertex (so there are no sinks) and end at m, every edge leads to a vertex, every owner is
+ * 1 or 2 and no priority is larger than the one in the header
+ *
+ * @param h the header of the file
+ * @param base the start of the mapping
+ * @param sections where each section starts, see binaryLayout
+ * @return int 1 if the game is valid
+ */
+static int validBinaryGame(const binaryGameHeader *h, const char *base, const size_t *sections) {
+    const uint8_t *owner = (const uint8_t *) (base + sections[0]);
+    const uint32_t *priority = (const uint32_t *) (base + sections[1]);
+    const uint32_t *offsets = (const uint32_t *) (base + sections[2]);
+    const uint32_t *targets = (const uint32_t *) (base + sections[3]);
+
+    if(offsets[0] != 0 || offsets[h->n] != h->m) {
+        return 0;
+    }
+    for(uint32_t v = 0; v < h->n; v++) {
+        if(offsets[v+1] <= offsets[v] || (owner[v] != 1 && owner[v] != 2) || priority[v] > h->maxPriority) {
+            return 0;
+        }
+    }
+    for(uint32_t e = 0; e < h->m; e++) {
+        if(targets[e] >= h->n) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * @brief maps a binary game file into memory. The arrays of the game point into the mapping, so nothing is read until
+ * it is used, apart from one pass that checks them
+ *
+ * @param fileName the path of the binary file
+ * @param sourceName the path of the text file it was converted from; the binary file is not used if the text file
+ * changed since then
+ * @param nMax the maximum number of vertices of a test game
+ * @param pMax the maximum priority of a test game
+ * @return game* the game, NULL if the file is not a valid binary game of a supported version and byte order, it is out
+ * of date or it does not meet the criteria of the benchmark
+ */
+game *loadBinaryGame(char *fileName, char *sourceName, long nMax, long pMax) {
+    struct stat st, source;
+    binaryGameHeader *h;
+    size_t sections[5];
+    char *base;
+    game *G;
+
+    int fd = open(fileName, O_RDONLY);
+    if(fd < 0) {
+        return NULL;
+    }
+    if(fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(binaryGameHeader)) {
+        close(fd);
+        return NULL;
+    }
+
+    //the mapping is private, so the arrays can be changed (see compressPriorities) without writing to the file
+    base = (char *) mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(base == MAP_FAILED) {
+        return NULL;
+    }
+
+    h = (binaryGameHeader *) base;
+    if(memcmp(h->magic, BINARY_GAME_MAGIC, 4) != 0 || h->version != BINARY_GAME_VERSION
+        || h->byteOrder != BINARY_GAME_BYTE_ORDER) {
+        munmap(base, st.st_size);
+        return NULL;
+    }
+    if(stat(sourceName, &source) == 0
+        && ((uint64_t) source.st_size != h->sourceSize || modificationTime(&source) != h->sourceTime)) {
+        printf("%s was converted from an older version of %s, using the text file\n", fileName, sourceName);
+        munmap(base, st.st_size);
+        return NULL;
+    }
+    if(h->n == 0 || h->n > nMax || h->maxPriority > pMax) {
+        munmap(base, st.st_size);
+        return NULL;
+    }
+    binaryLayout(h->n, h->m, sections);
+    if(sections[4] != (size_t) st.st_size || !validBinaryGame(h, base, sections)) {
+        printf("%s is damaged, using the text file\n", fileName);
+        munmap(base, st.st_size);
+        return NULL;
+    }
+
+    G = (game *) malloc(sizeof(game));
+    verify_alloc(G);
+    G->n = h->n;
+    G->m = h->m;
+    G->owner = (uint8_t *) (base + sections[0]);
+    G->priority = (uint32_t *) (base + sections[1]);
+    G->offsets = (uint32_t *) (base + sections[2]);
+    G->targets = (uint32_t *) (base + sections[3]);
+    G->deleted = (uint64_t *) calloc(G->m/64 + 1, sizeof(uint64_t));
+    verify_alloc(G->deleted);
+    G->mapping = base;
+    G->mappingSize = st.st_size;
+    G->shared = 0;
+
+    return G;
+}
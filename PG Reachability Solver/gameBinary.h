@@ -0,0 +1,32 @@
+#ifndef GAMEBINARY_H_INCLUDED
+#define GAMEBINARY_H_INCLUDED
+
+#include "utilities.h"
+
+#define BINARY_GAME_MAGIC "PGBG"
+#define BINARY_GAME_VERSION 2
+#define BINARY_GAME_EXTENSION ".bin"
+#define BINARY_GAME_BYTE_ORDER 0x01020304 //reads differently on a machine with another byte order
+
+/**
+ * @brief the header at the start of a binary game file
+ *
+ * It is followed by owner[n] (uint8_t), priority[n], offsets[n+1] and targets[m] (uint32_t),
+ * each section starting at a multiple of 8 bytes. All numbers are stored in the byte order of the machine that wrote
+ * the file.
+ */
+typedef struct binaryGameHeader {
+    char magic[4]; //BINARY_GAME_MAGIC
+    uint32_t version; //BINARY_GAME_VERSION
+    uint32_t byteOrder; //BINARY_GAME_BYTE_ORDER
+    uint32_t n; //number of vertices
+    uint32_t m; //number of edges
+    uint32_t maxPriority; //the maximum priority in the game
+    uint64_t sourceSize; //size of the text file the game was read from
+    int64_t sourceTime; //modification time of the text file, in nanoseconds since the epoch
+} binaryGameHeader;
+
+int writeBinaryGame(game *G, char *fileName, char *sourceName);
+game *loadBinaryGame(char *fileName, char *sourceName, long nMax, long pMax);
+
+#endif
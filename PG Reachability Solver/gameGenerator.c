@@ -1,171 +1,571 @@
 #include "gameGenerator.h"
 
 /**
- * @brief if word is a string that represents a positive integer, then return that integer, otherwise, return -1
- * 
- * @param word 
- * @return long 
+ * @brief prints the game. For debugging purposes
+ *
+ * @param G - the game; each line shows the owner and priority of a vertex, followed by its remaining outgoing edges
  */
-long toNumber(char *word) {
-    long result = 0;
-    int i;
-
+void printGraph(game *G) {
+    printf("n = %u\n", G->n);
+    for(uint32_t v=0; v < G->n; v++) {
+        printf("%u %u", G->owner[v], G->priority[v]);
+        for(uint32_t e = G->offsets[v]; e < G->offsets[v+1]; e++) {
+            if(!edgeDeleted(G, e)) {
+                printf(" %u", G->targets[e]);
+            }
+        }
+        printf("\n");
+    }
+}
 
-    if(strlen(word) > 9) {
-        //if word is indeed a number, but has more than 9 digits, it will not fit in long
-        return -1;
+/**
+ * @brief skips spaces, tabs and line breaks
+ *
+ * @param p - current position in the text
+ * @param end - end of the text
+ * @return const char* - the first position after p that is not whitespace
+ */
+static inline const char *skipSpace(const char *p, const char *end) {
+    while(p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) {
+        p++;
     }
+    return p;
+}
 
-    for(i=0; word[i] != '\0'; i++) {
-        if('0' <= word[i] && word[i] <= '9') {
-            result = result * 10 + (word[i] - '0');
+/**
+ * @brief reads the non-negative integer that starts at p, without copying it
+ *
+ * @param p - current position in the text
+ * @param end - end of the text
+ * @param x - the integer that was read
+ * @return const char* - the position after the last digit, NULL if p does not start with a digit or the integer does not fit in 32 bits
+ */
+static inline const char *scanNumber(const char *p, const char *end, uint64_t *x) {
+    uint64_t result = 0;
+
+    if(p == end || *p < '0' || *p > '9') {
+        return NULL;
+    }
+    while(p < end && '0' <= *p && *p <= '9') {
+        result = result * 10 + (*p - '0');
+        if(result > UINT32_MAX) {
+            return NULL;
         }
-        else return -1;
+        p++;
     }
 
-    return result;
+    *x = result;
+    return p;
 }
 
 /**
- * @brief prints the graph. For debugging purposes
- * 
- * @param n - number of vertices
- * @param G - the graph; G[v][0] represents the owner of v, G[v][1] = omega(v), if G[v][i] > -1, the edge (v, G[v][i]) is in the graph (i > 1)
+ * @brief skips the rest of a line, including an optional quoted vertex name
+ *
+ * @param p - current position in the text
+ * @param end - end of the text
+ * @return const char* - the position after the ';' that closes the line, or end
  */
-void printGraph(long *n, long **G) {
-    long j;
-    printf("n = %ld\n", *n);
-    for(long i=0; i < *n; i++) {
-        j=0;
-        while(G[i][j] != -2) {
-            printf("%ld ", G[i][j]);
-            j++;
+static inline const char *skipLine(const char *p, const char *end) {
+    while(p < end && *p != ';') {
+        if(*p == '"') {
+            //vertex names may contain ';'
+            p++;
+            while(p < end && *p != '"') {
+                p++;
+            }
+            if(p == end) {
+                break;
+            }
         }
-        printf("\n");
+        p++;
+    }
+    if(p < end) {
+        p++;
     }
+    return p;
 }
 
-long getN(char *input) {
-    char *n;
-    int i=0;
+/**
+ * @brief reads the header line "parity x;" and prepares the builder for a game with x+1 vertices
+ *
+ * @param b - the builder
+ * @param p - start of the text
+ * @param end - end of the text
+ * @param nMax - the maximum number of vertices of a test game
+ * @param pMax - the maximum priority of a test game
+ * @param mCapacity - number of edges to allocate room for; more room is allocated when needed
+ * @return const char* - the position after the header, NULL if the text is not a parity game or it does not meet the criteria of the benchmark
+ */
+const char *startBuilder(gameBuilder *b, const char *p, const char *end, long nMax, long pMax, uint64_t mCapacity) {
+    uint64_t x;
+
+    memset(b, 0, sizeof(gameBuilder));
+
     //all test cases start with the line "parity x;" where x is the number of the last vertex (so there are x+1 vertices, starting from 0)
-    n = strtok(input, " ;");
-    n = strtok(NULL, " ;");
+    p = skipSpace(p, end);
+    if(end - p < 6 || memcmp(p, "parity", 6) != 0) {
+        return NULL;
+    }
+    p = scanNumber(skipSpace(p + 6, end), end, &x);
+    if(p == NULL || x + 1 > (uint64_t) nMax || x + 1 > UINT32_MAX) {
+        //we only consider test cases for which n <= nMax
+        return NULL;
+    }
+
+    if(mCapacity > UINT32_MAX) {
+        mCapacity = UINT32_MAX;
+    }
+    b->G = newGame(x + 1, mCapacity);
+    b->capacity = mCapacity;
+    b->pMax = pMax;
 
-    return toNumber(n) + 1; 
-} 
+    return skipLine(p, end);
+}
 
 /**
- * @brief 
- * 
- * @param n - pointer to the number of vertices
- * @return long** - the graph; G[v][0] represents the owner of v, G[v][1] = omega(v), if G[v][i] > -1, the edge (v, G[v][i]) is in the graph (i > 1)
+ * @brief stops assuming that the vertices are listed in order, remembering where the edges of each vertex read so far are
+ *
+ * @param b - the builder
  */
-long **createPG(FILE *file, long *n, long nMax, long pMax) {
-    long **G;
-    char c;
-    int firstLine = 1; //indicates if we are reading the first line or a different one
-    char *inputLine;
-    long ilSize; //current size of the inputLine array
-    long gvSize; //size of G[v]
-    long i, j;
-    long v, w;
-    char *token;
-
-    do{
-        i=-1;
-        ilSize = 20;
-        inputLine = (char *) malloc(ilSize * sizeof(char));
-        do {
-            c = fgetc(file);
-            i++;
-            if(i >= ilSize) {
-                ilSize = ilSize * 2;
-                inputLine = (char *) realloc(inputLine, ilSize * sizeof(char));
+static void switchToUnordered(gameBuilder *b) {
+    game *G = b->G;
+
+    b->first = (uint32_t *) malloc(G->n * sizeof(uint32_t));
+    b->count = (uint32_t *) calloc(G->n, sizeof(uint32_t));
+    verify_alloc(b->first);
+    verify_alloc(b->count);
+
+    for(uint32_t v = 0; v < b->next; v++) {
+        b->first[v] = G->offsets[v];
+        b->count[v] = G->offsets[v+1] - G->offsets[v];
+    }
+}
+
+/**
+ * @brief reads the vertex lines in [p, end) straight into the game. The text must end at the end of a line
+ *
+ * @param b - the builder
+ * @param p - start of the text
+ * @param end - end of the text
+ * @return int - 1 on success, 0 if the game is malformed or does not meet the criteria of the benchmark
+ */
+int parseLines(gameBuilder *b, const char *p, const char *end) {
+    game *G = b->G;
+    const char *q;
+    uint64_t v, priority, owner, w;
+    uint64_t first; //position of the first edge of v in G->targets
+
+    while((p = skipSpace(p, end)) < end) {
+        if(*p < '0' || *p > '9') {
+            //some test cases have additional lines before the vertices, such as "start x;"
+            p = skipLine(p, end);
+            continue;
+        }
+
+        p = scanNumber(p, end, &v); //the vertex which the line describes
+        if(p == NULL || v >= G->n) {
+            return 0;
+        }
+        p = scanNumber(skipSpace(p, end), end, &priority);
+        if(p == NULL || priority > (uint64_t) b->pMax) {
+            //The maximum priority of the graph is higher than the one we set
+            return 0;
+        }
+        p = scanNumber(skipSpace(p, end), end, &owner);
+        if(p == NULL || owner > 1) {
+            return 0;
+        }
+
+        if(v != b->next && b->first == NULL) {
+            switchToUnordered(b);
+        }
+        if(b->first != NULL && b->count[v] > 0) {
+            //the vertex was already described
+            return 0;
+        }
+
+        G->priority[v] = priority;
+        G->owner[v] = 2 - owner;
+        first = b->m;
+
+        //read the comma separated list of successors
+        p = skipSpace(p, end);
+        while((q = scanNumber(p, end, &w)) != NULL) {
+            p = q;
+            if(w >= G->n || b->m == UINT32_MAX) {
+                return 0;
             }
-            inputLine[i] = c;
-        }while(c != '\n' && c != EOF);
-        inputLine[i] = '\0';
-
-
-        if(firstLine) {
-            firstLine = 0;
-            *n = getN(inputLine);
-            if(*n < 0 || *n > nMax) {
-                //we only consider test cases for which n <= nMax
-                *n = -1;
-                free(inputLine);
-                return NULL;
+            if(b->m == b->capacity) {
+                b->capacity = b->capacity * 2 + 16;
+                if(b->capacity > UINT32_MAX) {
+                    b->capacity = UINT32_MAX;
+                }
+                G->targets = (uint32_t *) realloc(G->targets, b->capacity * sizeof(uint32_t));
+                verify_alloc(G->targets);
             }
+            G->targets[b->m] = w;
+            b->m++;
 
-            G = (long **) malloc((*n) * sizeof(long));
-        } 
+            p = skipSpace(p, end);
+            if(p == end || *p != ',') {
+                break;
+            }
+            p = skipSpace(p + 1, end);
+        }
+        p = skipLine(p, end);
+
+        if(b->m == first) {
+            //Graph has a sink, pgSolver3 does not work for graphs with sinks
+            return 0;
+        }
+
+        if(b->first == NULL) {
+            G->offsets[v] = first;
+            G->offsets[v+1] = b->m;
+            b->next++;
+        }
         else {
-            token = strtok(inputLine, " ,;");
-            if(token == NULL) {
-                break; //account for some test files having an additonal new line at the end
+            b->first[v] = first;
+            b->count[v] = b->m - first;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * @brief frees everything held by the builder, including the unfinished game
+ *
+ * @param b - the builder
+ */
+void abortBuilder(gameBuilder *b) {
+    freeGame(b->G);
+    free(b->first);
+    free(b->count);
+    b->G = NULL;
+    b->first = NULL;
+    b->count = NULL;
+}
+
+/**
+ * @brief completes the game once all lines have been read
+ *
+ * @param b - the builder
+ * @return game* - the game, NULL if some vertex was never described
+ */
+game *finishBuilder(gameBuilder *b) {
+    game *G = b->G;
+    uint32_t *targets;
+    uint32_t v, m;
+
+    if(b->first == NULL) {
+        if(b->next != G->n) {
+            abortBuilder(b);
+            return NULL;
+        }
+    }
+    else {
+        //the vertices were not listed in order, so the edges are copied into place
+        targets = (uint32_t *) malloc((b->m + 1) * sizeof(uint32_t));
+        verify_alloc(targets);
+        m = 0;
+        for(v = 0; v < G->n; v++) {
+            if(b->count[v] == 0) {
+                abortBuilder(b);
+                free(targets);
+                return NULL;
             }
-            v = toNumber(token); //the vertex which the line describes
-            if(v < 0) {
-                //some test cases start listing the graph specifications from the 3rd line
-                free(inputLine);
-                continue;
+            memcpy(targets + m, G->targets + b->first[v], b->count[v] * sizeof(uint32_t));
+            G->offsets[v] = m;
+            m = m + b->count[v];
+        }
+        free(G->targets);
+        G->targets = targets;
+        free(b->first);
+        free(b->count);
+        b->first = NULL;
+        b->count = NULL;
+    }
+
+    G->m = b->m;
+    G->offsets[G->n] = b->m;
+    if(b->capacity > b->m) {
+        G->targets = (uint32_t *) realloc(G->targets, (b->m + 1) * sizeof(uint32_t));
+        verify_alloc(G->targets);
+    }
+    free(G->deleted);
+    G->deleted = (uint64_t *) calloc(G->m/64 + 1, sizeof(uint64_t));
+    verify_alloc(G->deleted);
+
+    b->G = NULL;
+    return G;
+}
+
+/**
+ * @brief reads a parity game in Keiren's format by mapping the file into memory and parsing it in one pass
+ *
+ * @param fileName - the path of the test file
+ * @param nMax - the maximum number of vertices of a test game
+ * @param pMax - the maximum priority of a test game
+ * @return game* - the game, NULL if it does not meet the criteria of the benchmark
+ */
+game *mapPG(char *fileName, long nMax, long pMax) {
+    gameBuilder b;
+    struct stat st;
+    const char *text, *p, *end;
+    game *G = NULL;
+
+    int fd = open(fileName, O_RDONLY);
+    if(fd < 0) {
+        printf("Error while opening file\n");
+        return NULL;
+    }
+    if(fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return NULL;
+    }
+
+    text = (const char *) mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(text == MAP_FAILED) {
+        printf("Error while mapping file\n");
+        return NULL;
+    }
+    madvise((void *) text, st.st_size, MADV_SEQUENTIAL);
+    end = text + st.st_size;
+
+    //every edge takes at least two characters, so the targets never need to grow
+    p = startBuilder(&b, text, end, nMax, pMax, st.st_size / 2 + 1);
+    if(p != NULL) {
+        if(parseLines(&b, p, end)) {
+            G = finishBuilder(&b);
+        }
+        else abortBuilder(&b);
+    }
+
+    munmap((void *) text, st.st_size);
+
+    return G;
+}
+
+/**
+ * @brief opens a compressed test file for reading
+ *
+ * @param r - the reader
+ * @param fileName - the path of the compressed file
+ * @param type - GZIP_STREAM or BZIP2_STREAM
+ * @return int - 1 on success
+ */
+static int openStream(compressedStream *r, char *fileName, int type) {
+    int bzError;
+
+    memset(r, 0, sizeof(compressedStream));
+    r->type = type;
+
+    if(type == GZIP_STREAM) {
+        r->gz = gzopen(fileName, "rb");
+        if(r->gz == NULL) {
+            return 0;
+        }
+        gzbuffer(r->gz, STREAM_CHUNK);
+        return 1;
+    }
+
+    r->fp = fopen(fileName, "rb");
+    if(r->fp == NULL) {
+        return 0;
+    }
+    r->bz = BZ2_bzReadOpen(&bzError, r->fp, 0, 0, NULL, 0);
+    if(bzError != BZ_OK) {
+        BZ2_bzReadClose(&bzError, r->bz);
+        fclose(r->fp);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief decompresses the next part of the file
+ *
+ * @param r - the reader
+ * @param buffer - where the decompressed text is written
+ * @param size - the size of buffer
+ * @return long - number of bytes written to buffer, 0 at the end of the file, -1 if the file is corrupt
+ */
+static long readStream(compressedStream *r, char *buffer, long size) {
+    int bzError, nUnused;
+    void *unused;
+    char rest[BZ_MAX_UNUSED];
+    long read;
+
+    if(size > INT_MAX) {
+        size = INT_MAX;
+    }
+
+    if(r->type == GZIP_STREAM) {
+        read = gzread(r->gz, buffer, size);
+        return read < 0 ? -1 : read;
+    }
+
+    while(1) {
+        if(r->streamEnd) {
+            //files compressed in parallel consist of several bzip2 streams, the next one starts with the unused input
+            BZ2_bzReadGetUnused(&bzError, r->bz, &unused, &nUnused);
+            memcpy(rest, unused, nUnused);
+            BZ2_bzReadClose(&bzError, r->bz);
+            r->bz = NULL;
+            if(nUnused == 0 && (fread(rest, 1, 1, r->fp) == 0)) {
+                return 0;
+            }
+            if(nUnused == 0) {
+                nUnused = 1; //the byte that was read to look for another stream
             }
-            gvSize = 20;
-            G[v] = (long *) malloc (gvSize * sizeof(long));
-            token = strtok(NULL, " ,;");
-            G[v][1] = toNumber(token); //the priority of the vertex v
-            if(G[v][1] > pMax) {
-                //The maximum priority of the graph is higher than the one we set
-                free(inputLine);
-                freeGraph(v+1, G);
-                *n = -1;
+            r->bz = BZ2_bzReadOpen(&bzError, r->fp, 0, 0, rest, nUnused);
+            if(bzError != BZ_OK) {
+                return -1;
+            }
+            r->streamEnd = 0;
+        }
 
-                return NULL;
+        read = BZ2_bzRead(&bzError, r->bz, buffer, size);
+        if(bzError == BZ_STREAM_END) {
+            r->streamEnd = 1;
+            if(read > 0) {
+                return read;
             }
+            continue;
+        }
+        if(bzError != BZ_OK) {
+            return -1;
+        }
+        return read;
+    }
+}
 
-            token = strtok(NULL, " ,;");
-            j = 1;
-            do {
-                if(j == 1) {
-                    G[v][0] = 2 - toNumber(token); //the owner of v
-                    j++;
-                } else {
-                    if(j >= gvSize) {
-                        gvSize = gvSize * 2;
-                        G[v] = (long *) realloc(G[v], gvSize * sizeof(long));
-                    }
-                    G[v][j] = w;
-                    j++;
-                }
-                token = strtok(NULL, " ,;");
-                w = -1;
-                if(token != NULL) {
-                    w = toNumber(token);
-                }
-            }while(w >= 0);
+/**
+ * @brief closes a compressed test file
+ *
+ * @param r - the reader
+ */
+static void closeStream(compressedStream *r) {
+    int bzError;
 
-            if(j == 2) {
-                //Graph has a sink, pgSolver3 does not work for graphs with sinks
-                *n = -1;
-                free(inputLine);
-                freeGraph(v+1, G);
-                return NULL;
+    if(r->type == GZIP_STREAM) {
+        gzclose(r->gz);
+        return;
+    }
+    if(r->bz != NULL) {
+        BZ2_bzReadClose(&bzError, r->bz);
+    }
+    fclose(r->fp);
+}
+
+/**
+ * @brief reads a compressed parity game in Keiren's format. The file is decompressed one chunk at a time and every
+ * complete line is parsed straight into the game, so the decompressed text is never stored as a whole
+ *
+ * @param fileName - the path of the compressed test file
+ * @param nMax - the maximum number of vertices of a test game
+ * @param pMax - the maximum priority of a test game
+ * @param type - GZIP_STREAM or BZIP2_STREAM
+ * @return game* - the game, NULL if it does not meet the criteria of the benchmark
+ */
+game *streamPG(char *fileName, long nMax, long pMax, int type) {
+    compressedStream r;
+    gameBuilder b;
+    struct stat st;
+    long size = STREAM_CHUNK; //size of the buffer
+    long filled = 0; //number of decompressed bytes in the buffer
+    long read;
+    int started = 0; //1 once the header has been read
+    int ok = 1;
+    const char *p, *lineEnd;
+    game *G = NULL;
+
+    if(stat(fileName, &st) != 0 || !openStream(&r, fileName, type)) {
+        printf("Error while opening file\n");
+        return NULL;
+    }
+
+    char *buffer = (char *) malloc(size * sizeof(char));
+    verify_alloc(buffer);
+
+    do {
+        if(filled == size) {
+            //a single line does not fit in the buffer
+            size = size * 2;
+            buffer = (char *) realloc(buffer, size * sizeof(char));
+            verify_alloc(buffer);
+        }
+
+        read = readStream(&r, buffer + filled, size - filled);
+        if(read < 0) {
+            ok = 0;
+            break;
+        }
+        filled = filled + read;
+
+        //only complete lines are parsed, the rest is kept for the next chunk
+        if(read == 0) {
+            lineEnd = buffer + filled;
+        }
+        else {
+            lineEnd = buffer + filled;
+            while(lineEnd > buffer && lineEnd[-1] != '\n') {
+                lineEnd--;
             }
-            if(j >= gvSize) {
-                gvSize++;
-                G[v] = (long *) realloc(G[v], gvSize * sizeof(long));
+            if(lineEnd == buffer) {
+                continue;
+            }
+        }
+
+        p = buffer;
+        if(!started) {
+            //the compressed size is a lower bound for the number of edges, the targets grow when needed
+            p = startBuilder(&b, buffer, lineEnd, nMax, pMax, st.st_size);
+            if(p == NULL) {
+                ok = 0;
+                break;
             }
-            G[v][j] = -2;
+            started = 1;
+        }
+        if(!parseLines(&b, p, lineEnd)) {
+            ok = 0;
+            break;
         }
 
-        free(inputLine);
+        filled = buffer + filled - lineEnd;
+        memmove(buffer, lineEnd, filled);
+    }while(read > 0);
 
-    }while(c != EOF);
+    if(started) {
+        if(ok) {
+            G = finishBuilder(&b);
+        }
+        else abortBuilder(&b);
+    }
 
+    closeStream(&r);
+    free(buffer);
 
     return G;
+}
 
+/**
+ * @brief reads a parity game in Keiren's format. Files ending in .gz or .bz2 are decompressed while they are read
+ *
+ * @param fileName - the path of the test file
+ * @param nMax - the maximum number of vertices of a test game
+ * @param pMax - the maximum priority of a test game
+ * @return game* - the game, NULL if it does not meet the criteria of the benchmark
+ */
+game *createPG(char *fileName, long nMax, long pMax) {
+    if(hasSuffix(fileName, ".gz")) {
+        return streamPG(fileName, nMax, pMax, GZIP_STREAM);
+    }
+    if(hasSuffix(fileName, ".bz2")) {
+        return streamPG(fileName, nMax, pMax, BZIP2_STREAM);
+    }
 
+    return mapPG(fileName, nMax, pMax);
 }
-
@@ -1,9 +1,47 @@
 #ifndef GAMEGENERATOR_H_INCLUDED
 #define GAMEGENERATOR_H_INCLUDED
 
+#include <zlib.h>
+#include <bzlib.h>
+
 #include "utilities.h"
 
-long **createPG(FILE *file, long *n, long nMax, long pMax);
-void printGraph(long *n, long **G);
+#define STREAM_CHUNK (1 << 20) //number of bytes decompressed at once
+#define GZIP_STREAM 1
+#define BZIP2_STREAM 2
+
+/**
+ * @brief the state of a game that is being read from text in Keiren's format
+ */
+typedef struct gameBuilder {
+    game *G; //the game that is being filled
+    long pMax; //the maximum priority of a test game
+    uint64_t m; //number of edges read so far
+    uint64_t capacity; //allocated size of G->targets
+    uint32_t next; //the vertex expected on the next line while the vertices are listed in order
+    uint32_t *first; //first[v] - position of the first edge of v, only used once the vertices are not listed in order
+    uint32_t *count; //count[v] - number of edges of v, only used once the vertices are not listed in order
+} gameBuilder;
+
+/**
+ * @brief a compressed test file that is being read
+ */
+typedef struct compressedStream {
+    int type; //GZIP_STREAM or BZIP2_STREAM
+    gzFile gz; //the gzip file
+    FILE *fp; //the bzip2 file
+    BZFILE *bz; //the current bzip2 stream of fp
+    int streamEnd; //1 if bz has been read completely
+} compressedStream;
+
+const char *startBuilder(gameBuilder *b, const char *p, const char *end, long nMax, long pMax, uint64_t mCapacity);
+int parseLines(gameBuilder *b, const char *p, const char *end);
+game *finishBuilder(gameBuilder *b);
+void abortBuilder(gameBuilder *b);
+
+game *mapPG(char *fileName, long nMax, long pMax);
+game *streamPG(char *fileName, long nMax, long pMax, int type);
+game *createPG(char *fileName, long nMax, long pMax);
+void printGraph(game *G);
 
-#endif
\ No newline at end of file
+#endif
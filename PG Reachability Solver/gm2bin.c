@@ -0,0 +1,45 @@
+#include "utilities.h"
+#include "gameGenerator.h"
+#include "gameBinary.h"
+
+/**
+ * @brief converts parity games from Keiren's text format to the binary game format.
+ * Every file.gm given as an argument is stored as file.gm.bin, which benchmarkTestSet loads instead of the text file
+ */
+int main(int argc, char **argv) {
+    char *binName;
+    game *G;
+    int failed = 0;
+
+    if(argc < 2) {
+        printf("Usage: %s file.gm ...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    for(int i = 1; i < argc; i++) {
+        G = createPG(argv[i], UINT32_MAX, UINT32_MAX);
+        if(G == NULL) {
+            printf("%s: not a parity game without sinks, skipped\n", argv[i]);
+            failed = 1;
+            continue;
+        }
+
+        binName = (char *) malloc((strlen(argv[i]) + strlen(BINARY_GAME_EXTENSION) + 1) * sizeof(char));
+        verify_alloc(binName);
+        strcpy(binName, argv[i]);
+        strcat(binName, BINARY_GAME_EXTENSION);
+
+        if(writeBinaryGame(G, binName, argv[i])) {
+            printf("%s: %u vertices, %u edges\n", binName, G->n, G->m);
+        }
+        else {
+            printf("Error while writing %s\n", binName);
+            failed = 1;
+        }
+
+        free(binName);
+        freeGame(G);
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
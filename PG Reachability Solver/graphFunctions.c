@@ -1,48 +1,64 @@
 #include "graphFunctions.h"
+#include "parallelScc.h"
 #include "utilities.h"
 
 
 /**
- * @brief adds all strongly connected components of X[r] to X
+ * @brief adds all strongly connected components of X[r] to X, in reverse topological order: the subsets that
+ * cannot reach any other subset are placed last, so they are solved first
  * 
  * @param X array of subsets of G
  * @param r largest occupied position in X
- * @param G the graph with all the parity game information; G[x][0] - owner of node x; G[x][1] - priority of x; G[x][k] > -1, k > 1, (x, G[x][k]) is an edge 
- * @param n number of nodes of the graph
+ * @param G the game
+ * @param local scratch array of n entries, all -1; it is -1 again when the function returns
+ * @param P the state of the parallel split made by the solver, NULL if --parallel-scc is not used
  * @return long the new largest occupied position in X
  */
-long addSubsets(long **X, long r, long **G, long n) {
+long addSubsets(long **X, long r, game *G, long *local, sccShared *P) {
     long s; //number of strongly connected components of X[r]
-    long **F; //array of strongly connected components of X[r]
+    long *comp; //comp[x] - the strongly connected component of X[r][x], numbered in the order they were found
+    long *subset = X[r]; //the subset which is split
     long xn = 0; //number of vertices in X[r]
-    long *Xsize; //X[i] - number of occupied positions in the array X[r+i]
+    long *Xsize; //Xsize[i] - number of occupied positions in the array X[r+i]
     long i, j;
-    F = strConnComp(X[r], G, n, &s);
    
-    while(X[r][xn] >= 0) {
+    while(subset[xn] >= 0) {
         xn++;
     }
-    free(X[r]);
+
+    //large subsets are split by several threads when --parallel-scc is given
+    if(P != NULL && xn >= options.sccThreshold) {
+        comp = parallelStrConnComp(subset, P, &s);
+    }
+    else comp = strConnComp(subset, G, local, &s);
+
+    //the component found k-th goes to X[r+s-k]
+    Xsize = (long *) calloc(s, sizeof(long));
+    verify_alloc(Xsize);
+    for(j=0; j<xn; j++) {
+        Xsize[s - comp[j]]++;
+    }
 
     //initialize the subsets X[r]...X[r+s-1]
-    Xsize = (long *) malloc (s* sizeof(long));
     for(i=0; i<s; i++) {
-        X[r+i] = (long *) malloc((xn+1) * sizeof(long));
+        X[r+i] = (long *) malloc((Xsize[i]+1) * sizeof(long));
+        verify_alloc(X[r+i]);
         Xsize[i] = 0;
-        X[r+i][0] = -2;
     } 
 
     //Add the nodes to their respective subset
     for(j=0; j<xn; j++) {
-        i = s - F[j][0];
-        X[r+i][Xsize[i]] = F[j][1];
+        i = s - comp[j];
+        X[r+i][Xsize[i]] = subset[j];
         Xsize[i]++;
+    }
+    for(i=0; i<s; i++) {
         X[r+i][Xsize[i]] = -2;
-        free(F[j]);
     }
 
     free(Xsize);
-    free(F);
+    free(comp);
+    free(subset);
 
     return r+s-1;
 }
@@ -50,205 +66,482 @@ long addSubsets(long **X, long r, long **G, long n) {
 
 
 /**
- * @brief find the strongly connected components of the subgraph of G with the nodes from X
+ * @brief stores the edges of G that have not been removed in compressed sparse row form, so loops over them do not
+ * have to test the removed edges. The live edges of v are liveTargets[liveOffsets[v]], ..., liveTargets[liveOffsets[v+1] - 1]
+ *
+ * @param G the game
+ * @param liveOffsets n+1 entries
+ * @param liveTargets room for G->m entries
+ * @return uint32_t number of live edges
+ */
+uint32_t liveEdges(const game *G, uint32_t *liveOffsets, uint32_t *liveTargets) {
+    uint32_t ml = 0;
+
+    for(uint32_t v = 0; v < G->n; v++) {
+        liveOffsets[v] = ml;
+        for(uint32_t e = G->offsets[v]; e < G->offsets[v+1]; e++) {
+            if(!edgeDeleted(G, e)) {
+                liveTargets[ml] = G->targets[e];
+                ml++;
+            }
+        }
+    }
+    liveOffsets[G->n] = ml;
+
+    return ml;
+}
+
+/**
+ * @brief appends the edge (v1, v2) to the list
+ *
+ * @param L the list, {NULL, 0, 0} when empty
+ * @param v1 the source of the edge
+ * @param v2 the target of the edge
+ */
+void addEdge(edgeList *L, unsigned long v1, unsigned long v2) {
+    if(L->size == L->capacity) {
+        L->capacity = L->capacity * 2 + 16;
+        L->F = (edge *) realloc(L->F, L->capacity * sizeof(edge));
+        verify_alloc(L->F);
+    }
+    L->F[L->size].v1 = v1;
+    L->F[L->size].v2 = v2;
+    L->size++;
+}
+
+/**
+ * @brief joins several lists into one array of edges, ending with the edge (-1, -1). The lists are freed
+ *
+ * @param L the lists
+ * @param count number of lists
+ * @return edge* the edges of L[0], followed by the edges of L[1], ...
+ */
+edge *mergeEdgeLists(edgeList *L, int count) {
+    long size = 0, idx = 0;
+    edge *F;
+
+    for(int t = 0; t < count; t++) {
+        size = size + L[t].size;
+    }
+    F = (edge *) malloc((size + 1) * sizeof(edge));
+    verify_alloc(F);
+    for(int t = 0; t < count; t++) {
+        if(L[t].size > 0) {
+            memcpy(F + idx, L[t].F, L[t].size * sizeof(edge));
+            idx = idx + L[t].size;
+        }
+        free(L[t].F);
+        L[t].F = NULL;
+        L[t].size = L[t].capacity = 0;
+    }
+    F[idx].v1 = -1;
+    F[idx].v2 = -1;
+
+    return F;
+}
+
+/**
+ * @brief removes the edges of F from the game. For every (v1, v2) in F one edge from v1 to v2 that is still in the game is removed
+ *
+ * @param G the game
+ * @param F the edges, ending with (-1, -1)
+ * @return long number of removed edges
+ */
+long removeEdges(game *G, edge *F) {
+    long k = 0;
+    uint32_t j;
+
+    while(F[k].v1 != (unsigned long) -1) {
+        j = G->offsets[F[k].v1];
+        while(edgeDeleted(G, j) || G->targets[j] != F[k].v2) {
+            j++;
+        }
+        removeEdge(G, j);
+        k++;
+    }
+
+    return k;
+}
+
+/**
+ * @brief finds the vertices that can reach the source of an edge of F, including the sources themselves
+ *
+ * @param G the game
+ * @param F the edges, ending with (-1, -1)
+ * @return long* the vertices, ending with -2
+ */
+long *reachingVertices(game *G, edge *F) {
+    uint32_t *predOffsets = (uint32_t *) malloc((G->n + 1) * sizeof(uint32_t));
+    uint32_t *predSources = (uint32_t *) malloc((G->m + 1) * sizeof(uint32_t));
+    uint32_t *outDegree = (uint32_t *) malloc((G->n + 1) * sizeof(uint32_t));
+    uint8_t *seen = (uint8_t *) calloc(G->n + 1, sizeof(uint8_t));
+    long *X = (long *) malloc((G->n + 1) * sizeof(long)); //the vertices found so far, also the queue
+    long qi, qmax = 0;
+    uint32_t v, i;
+    verify_alloc(predOffsets);
+    verify_alloc(predSources);
+    verify_alloc(outDegree);
+    verify_alloc(seen);
+    verify_alloc(X);
+
+    buildPredecessors(G, predOffsets, predSources, outDegree);
+
+    for(long k = 0; F[k].v1 != (unsigned long) -1; k++) {
+        if(!seen[F[k].v1]) {
+            seen[F[k].v1] = 1;
+            X[qmax++] = F[k].v1;
+        }
+    }
+    for(qi = 0; qi < qmax; qi++) {
+        v = X[qi];
+        for(i = predOffsets[v]; i < predOffsets[v+1]; i++) {
+            if(!seen[predSources[i]]) {
+                seen[predSources[i]] = 1;
+                X[qmax++] = predSources[i];
+            }
+        }
+    }
+    X[qmax] = -2;
+
+    free(predOffsets);
+    free(predSources);
+    free(outDegree);
+    free(seen);
+
+    return X;
+}
+
+/**
+ * @brief creates the subgame of G with the vertices of X, copying the edges that are not removed and stay inside X
+ * into a local CSR index, in time and memory linear in the size of the subgame
+ *
+ * @param S the subgame
+ * @param X the subset of vertices, terminated by a negative value
+ * @param G the game
+ * @param local scratch array of n entries, all -1; it is -1 again once the subgame is freed
+ */
+void copySubgame(subgame *S, long *X, const game *G, long *local) {
+    long xn = 0, x;
+    uint32_t e, mx = 0;
+
+    while(X[xn] >= 0) {
+        local[X[xn]] = xn;
+        xn++;
+    }
+
+    S->G = G;
+    S->vertices = X;
+    S->xn = xn;
+    S->local = local;
+    S->offsets = (uint32_t *) malloc((xn + 1) * sizeof(uint32_t));
+    S->winner = (int *) calloc(xn + 1, sizeof(int));
+    verify_alloc(S->offsets);
+    verify_alloc(S->winner);
+
+    //count the edges that stay inside the subgame
+    for(x = 0; x < xn; x++) {
+        S->offsets[x] = mx;
+        for(e = G->offsets[X[x]]; e < G->offsets[X[x]+1]; e++) {
+            if(!edgeDeleted(G, e) && local[G->targets[e]] >= 0) {
+                mx++;
+            }
+        }
+    }
+    S->offsets[xn] = mx;
+
+    S->targets = (uint32_t *) malloc((mx + 1) * sizeof(uint32_t));
+    verify_alloc(S->targets);
+    mx = 0;
+    for(x = 0; x < xn; x++) {
+        for(e = G->offsets[X[x]]; e < G->offsets[X[x]+1]; e++) {
+            if(!edgeDeleted(G, e) && local[G->targets[e]] >= 0) {
+                S->targets[mx++] = local[G->targets[e]];
+            }
+        }
+    }
+}
+
+/**
+ * @brief resets the global to local map of the subgame and frees its edges and winners
+ *
+ * @param S the subgame
+ */
+void freeSubgame(subgame *S) {
+    for(long x = 0; x < S->xn; x++) {
+        S->local[S->vertices[x]] = -1;
+    }
+    free(S->offsets);
+    free(S->targets);
+    free(S->winner);
+    S->winner = NULL;
+}
+
+
+
+/**
+ * @brief find the strongly connected components of the subgraph of G with the nodes from X, with an iterative
+ * version of Tarjan's algorithm in O(|X| + number of edges leaving vertices of X)
  * 
  * @param X the subset of nodes which we need to split
- * @param G the graph with all the parity game information; G[x][0] - owner of node x; G[x][1] - priority of x; G[x][k] > -1, k > 1, (x, G[x][k]) is an edge 
- * @param n number of nodes in the graph
+ * @param G the game
+ * @param local scratch array of n entries, all -1; it is -1 again when the function returns
  * @param s number of strongly connected components of the subgraph G with the nodes from X
- * @return long** the subgraph of G with the nodes from X, with associated numbers for which scc they belong to
+ * @return long* comp[x] - the strongly connected component X[x] belongs to. Components are numbered from 1 in the order
+ * they are completed, which is a reverse topological order
  */
-long **strConnComp(long *X, long **G, long n, long *s) {
-    long i, j, k, l, a;
-    long solved = 0; //the number of vertices of X for which we identified what strongly connected component it is part of
-    *s = 0;
+long *strConnComp(long *X, game *G, long *local, long *s) {
     long xn = 0; //number of nodes in X
+    long x, y, root, counter = 0;
+    long sp = 0; //size of the stack of visited vertices without a component
+    long csp = 0; //size of the call stack of the depth first search
+    uint32_t e, v;
+
     while(X[xn] >= 0) {
+        local[X[xn]] = xn;
         xn++;
     }
 
-    long **F = (long **) malloc(xn * sizeof(long *)); //the subgraph of G with the nodes from X
-    for(long x = 0; x < xn; x++) {
-        long v = X[x];
-        F[x] = (long *) malloc((xn+3) * sizeof(long));
-        F[x][0] = 0; //vertex x does not yet belong to any strongly connected components
-        F[x][1] = v; //the vertex in G wich x corresponds to 
-        //Adding all outgoing edges of v that connect to other nodes from X
-        l=2;
-        for(i = 2; G[v][i] > -2; i++) {
-            if(G[v][i] > -1) {
-                for(j = 0; j < xn; j++) {
-                    if(X[j] == G[v][i]) {
-                        F[x][l] = j;
-                        l++;
-                    }
-                }
-            }
-        }
-        F[x][l] = -2;
+    long *comp = (long *) calloc(xn + 1, sizeof(long)); //0 while the vertex has no component yet
+    long *index = (long *) malloc((xn + 1) * sizeof(long)); //index[x] - order in which x was visited, -1 if not yet
+    long *low = (long *) malloc((xn + 1) * sizeof(long)); //low[x] - smallest index reachable from x among the vertices on the stack
+    long *stack = (long *) malloc((xn + 1) * sizeof(long));
+    long *callStack = (long *) malloc((xn + 1) * sizeof(long));
+    uint32_t *nextEdge = (uint32_t *) malloc((xn + 1) * sizeof(uint32_t)); //nextEdge[x] - the next edge of X[x] to examine
+    verify_alloc(comp);
+    verify_alloc(index);
+    verify_alloc(low);
+    verify_alloc(stack);
+    verify_alloc(callStack);
+    verify_alloc(nextEdge);
+
+    for(x = 0; x < xn; x++) {
+        index[x] = -1;
     }
+    *s = 0;
 
-    i=0;
-    long *v = (long *) malloc((xn+1) * sizeof(long)); //vertex v[x+1] is reachable from v[x]
-    long *m = (long *) malloc((xn + 1) * sizeof(long)); //for m[i] <= j <=i, v[j] is reachable from v[i]
-    long flag, w;
+    for(root = 0; root < xn; root++) {
+        if(index[root] != -1) {
+            continue;
+        }
 
-    while(solved < xn) {
+        //visit root
+        index[root] = low[root] = counter++;
+        stack[sp++] = root;
+        callStack[csp++] = root;
+        nextEdge[root] = G->offsets[X[root]];
 
-        if(i == 0) {
-            //initialize new list of vertices
-            i = 1;
-            for(k= 0; k<n; k++) {
-                if(F[k][0] == 0) {
-                    v[1] = k;
+        while(csp > 0) {
+            x = callStack[csp - 1];
+            v = X[x];
+            y = -1;
+
+            //find the next edge of x that leads to an unvisited vertex of X
+            while(nextEdge[x] < G->offsets[v+1]) {
+                e = nextEdge[x];
+                nextEdge[x]++;
+                if(edgeDeleted(G, e) || local[G->targets[e]] < 0) {
+                    continue;
+                }
+                y = local[G->targets[e]];
+                if(index[y] == -1) {
                     break;
                 }
+                if(comp[y] == 0 && index[y] < low[x]) {
+                    //y is still on the stack
+                    low[x] = index[y];
+                }
+                y = -1;
             }
-            m[1] = 1;
-            j = 1;
-            a = 2;
-        }
 
-        while(j <= i) {
-            w = -1;
-            //find a node w such that (v, w) is in F
-            for(a=2; F[v[j]][a] > -2; a++) {
-                w = F[v[j]][a];
-                if(w >= 0 && F[w][0] == 0) {
-                    break;
-                }
+            if(y != -1) {
+                //visit y
+                index[y] = low[y] = counter++;
+                stack[sp++] = y;
+                callStack[csp++] = y;
+                nextEdge[y] = G->offsets[X[y]];
+                continue;
             }
-            if(F[v[j]][a] >= 0) {
-                F[v[j]][a] = -1; //remove the edge 
-                flag = 0;
-                for(k = 1; k < m[i]; k++) {
-                    if(w == v[k]) { //v[k] reachable from v[j]
-                        //v[m[k]] is reachable from all v[m[l]] wiht l=k,...,i
-                        for(l = k + 1; l <= i; l++) {
-                            m[l] = m[k];
-                        }
-                        j = m[k];
-                        flag = 1;
-                        break;
-                    }
-                }
-                if(!flag) {
-                    for(k = m[i]; k <= i; k++) {
-                        if(w == v[k]) {
-                            break;
-                        }
-                    }
-                    
-                    //w is not yet in the list; new entry
-                    if(k == i+1) {
-                        i++;
-                        v[i] = w;
-                        m[i] = i;
-                        j = i;
-                    }
-                }
+
+            //all edges of x have been examined
+            if(low[x] == index[x]) {
+                //new scc found: the vertices on the stack down to x
+                (*s)++;
+                do {
+                    sp--;
+                    comp[stack[sp]] = *s;
+                }while(stack[sp] != x);
             }
-            else {
-                //no outgoing edges left from v[j]
-                j++;
+            csp--;
+            if(csp > 0 && low[x] < low[callStack[csp - 1]]) {
+                low[callStack[csp - 1]] = low[x];
             }
         }
+    }
 
-        //new scc found: {v[m[i]],...v[i]}
-        (*s)++;
-        for(k = m[i]; k<=i; k++) {
-            F[v[k]][0] = *s; //mark the vertex as belonging to the scc with number s
-        }
-        solved = solved + i - m[i] + 1; 
-        i = m[i] -1;
-        j = m[i];
+    for(x = 0; x < xn; x++) {
+        local[X[x]] = -1;
     }
 
-    free(v);
-    free(m);
+    free(index);
+    free(low);
+    free(stack);
+    free(callStack);
+    free(nextEdge);
 
-    return F;
+    return comp;
 }
 
 
 
 /**
- * @brief determines additional winning positions of player e through the equivalent reachability game
+ * @brief builds the predecessor lists of the game, ignoring removed edges
  * 
- * @param W W[x] - the player that has a winning positional strategy at vertex x
- * @param e the player number 
- * @param G the graph with all the parity game information; G[x][0] - owner of node x; G[x][1] - priority of x; G[x][k] > -1, k > 1, (x, G[x][k]) is an edge 
- * @param n number of nodes of the graph
+ * @param G the game
+ * @param predOffsets the predecessors of w are predSources[predOffsets[w]], ..., predSources[predOffsets[w+1] - 1]; n+1 entries
+ * @param predSources the sources of the edges, grouped by target; m entries
+ * @param outDegree outDegree[v] - number of remaining outgoing edges of v
  */
-void reach(int *W, unsigned int e, long **G, long n) {
-    long v, w;
-    long **E = (long **) malloc(n * sizeof(long *)); //E[v][w] = 1 means that (v, w) is in the graph
-    verify_alloc(E);
-
-    //initialize E
-    for(long i=0; i<n; i++) {
-        E[i] = (long *) malloc(n * sizeof(long));
-        verify_alloc(E[i]);
-        for(long j=0; j<n; j++) {
-            E[i][j] = 0;
+void buildPredecessors(game *G, uint32_t *predOffsets, uint32_t *predSources, uint32_t *outDegree) {
+    uint32_t v, e, w;
+
+    memset(predOffsets, 0, (G->n + 1) * sizeof(uint32_t));
+    for(v = 0; v < G->n; v++) {
+        outDegree[v] = 0;
+        for(e = G->offsets[v]; e < G->offsets[v+1]; e++) {
+            if(!edgeDeleted(G, e)) {
+                predOffsets[G->targets[e] + 1]++;
+                outDegree[v]++;
+            }
         }
     }
-    for(v=0; v<n; v++) {
-        for(long i=2; G[v][i] > -2; i++) {
-            w = G[v][i];
-            if(w != -1) {
-                E[v][w] = 1;
+    for(w = 0; w < G->n; w++) {
+        predOffsets[w+1] = predOffsets[w+1] + predOffsets[w];
+    }
+
+    //predOffsets[w] is used as the next free position for w while filling, then shifted back
+    for(v = 0; v < G->n; v++) {
+        for(e = G->offsets[v]; e < G->offsets[v+1]; e++) {
+            if(!edgeDeleted(G, e)) {
+                w = G->targets[e];
+                predSources[predOffsets[w]] = v;
+                predOffsets[w]++;
             }
         }
     }
+    for(w = G->n; w > 0; w--) {
+        predOffsets[w] = predOffsets[w-1];
+    }
+    predOffsets[0] = 0;
+}
 
-    long *Wqueue = (long *) malloc(n * sizeof(long)); //queue of winning positions for Pe
-    long qi=0, qmax = 0;
+/**
+ * @brief creates the attractor state of a game in which no vertex has a known winner yet.
+ * The edges of G must not change while the state is used
+ * 
+ * @param G the game
+ * @return attractor* the attractor state
+ */
+attractor *newAttractor(game *G) {
+    uint32_t n = G->n;
+    attractor *A = (attractor *) malloc(sizeof(attractor));
+    verify_alloc(A);
 
-    //initialize Wqueue
-    for(long v=0; v<n; v++) {
-        if(W[v] == e) {
-            Wqueue[qmax] = v;
-            qmax++;
-        }
+    A->G = G;
+    A->predOffsets = (uint32_t *) malloc((n + 1) * sizeof(uint32_t));
+    A->predSources = (uint32_t *) malloc((G->m + 1) * sizeof(uint32_t));
+    for(int e = 0; e < 2; e++) {
+        A->remaining[e] = (uint32_t *) malloc((n + 1) * sizeof(uint32_t));
+        A->queue[e] = (uint32_t *) malloc((n + 1) * sizeof(uint32_t));
+        A->queueSize[e] = 0;
+        verify_alloc(A->remaining[e]);
+        verify_alloc(A->queue[e]);
     }
-    
-    int flag;
-    for(qi = 0; qi < qmax; qi++) {
-        w = Wqueue[qi];
-        for(v = 0; v < n; v++) {
-            if(E[v][w] == 0) {
-                continue;
-            }
-            if(W[v] == e) {
-                continue;
-            }
-            flag = 1;
-            if(G[v][0] == e) {
-                //v is owned by Pe and has an edge to the winning position w
-                W[v] = e;
-                Wqueue[qmax] = v;
-                qmax++;
+    verify_alloc(A->predOffsets);
+    verify_alloc(A->predSources);
+
+    buildPredecessors(G, A->predOffsets, A->predSources, A->remaining[0]);
+    memcpy(A->remaining[1], A->remaining[0], n * sizeof(uint32_t));
+
+    return A;
+}
+
+/**
+ * @brief frees the attractor state
+ * 
+ * @param A the attractor state
+ */
+void freeAttractor(attractor *A) {
+    free(A->predOffsets);
+    free(A->predSources);
+    for(int e = 0; e < 2; e++) {
+        free(A->remaining[e]);
+        free(A->queue[e]);
+    }
+    free(A);
+}
+
+/**
+ * @brief records that player e wins at v; its predecessors are examined by the next call of attract
+ * 
+ * @param A the attractor state
+ * @param W W[x] - the player that has a winning positional strategy at vertex x
+ * @param v the vertex
+ * @param e the player number
+ */
+void setWinner(attractor *A, int *W, uint32_t v, unsigned int e) {
+    W[v] = e;
+    A->queue[e-1][A->queueSize[e-1]] = v;
+    A->queueSize[e-1]++;
+}
+
+/**
+ * @brief adds the attractor of player e to the winning positions of Pe, starting only from the positions that were
+ * won since the last call. Over a whole solve every vertex and every edge is examined at most once per player
+ * 
+ * @param A the attractor state
+ * @param W W[x] - the player that has a winning positional strategy at vertex x
+ * @param e the player number
+ */
+void attract(attractor *A, int *W, unsigned int e) {
+    game *G = A->G;
+    uint32_t *remaining = A->remaining[e-1]; //remaining[v] - number of edges of v that do not yet lead to a winning position for Pe
+    uint32_t *queue = A->queue[e-1];
+    uint32_t v, w, i;
+
+    while(A->queueSize[e-1] > 0) {
+        A->queueSize[e-1]--;
+        w = queue[A->queueSize[e-1]];
+        for(i = A->predOffsets[w]; i < A->predOffsets[w+1]; i++) {
+            v = A->predSources[i];
+            remaining[v]--;
+            if(W[v] != 0) {
                 continue;
             }
-            for(long i=0; i<n; i++) {
-                if(E[v][i] == 1 && W[i] != e) {
-                    flag =0;
-                    break;
-                }
+            if(G->owner[v] == e || remaining[v] == 0) {
+                //v is owned by Pe and has an edge to the winning position w,
+                //or v is not owned by Pe, but all edges lead to winning positions for Pe
+                setWinner(A, W, v, e);
             }
-            if(flag == 1) {
-                //w not owned by Pe, but all edges lead to winning positions for Pe
-                W[v] = e;
-                Wqueue[qmax] = v;
-                qmax++;
-            }  
-            
         }
     }
-    for(long i = 0; i<n; i++) {
-        free(E[i]);
+}
+
+/**
+ * @brief determines additional winning positions of player e through the equivalent reachability game, in O(n + m)
+ * 
+ * @param W W[x] - the player that has a winning positional strategy at vertex x
+ * @param e the player number 
+ * @param G the game
+ */
+void reach(int *W, unsigned int e, game *G) {
+    attractor *A = newAttractor(G);
+
+    for(uint32_t v = 0; v < G->n; v++) {
+        if(W[v] == (int) e) {
+            setWinner(A, W, v, e);
+        }
     }
-    free(E);
-    free(Wqueue);
-}
\ No newline at end of file
+    attract(A, W, e);
+
+    freeAttractor(A);
+}
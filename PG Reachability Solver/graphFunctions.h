@@ -1,14 +1,143 @@
 #ifndef GRAPHFUNCTIONS_H_INCLUDED
 #define GRAPHFUNCTIONS_H_INCLUDED
 
+#include "parityGame.h"
+#include "parallelScc.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
 typedef struct edge {
     unsigned long v1;
     unsigned long v2;
 } edge;   
 
-void reach(int *W, unsigned int e, long **G, long n);
-long addSubsets(long **X, long r, long **G, long n);
-long **strConnComp(long *X, long **G, long n, long *s);
+/**
+ * @brief a growing array of edges
+ */
+typedef struct edgeList {
+    edge *F; //the edges
+    long size; //number of edges in F
+    long capacity; //allocated size of F
+} edgeList;
+
+/**
+ * @brief the state of the attractor computation of both players, kept for a whole solve
+ */
+typedef struct attractor {
+    game *G; //the game
+    uint32_t *predOffsets; //the predecessors of w are predSources[predOffsets[w]], ..., predSources[predOffsets[w+1] - 1]
+    uint32_t *predSources;
+    uint32_t *remaining[2]; //remaining[e-1][v] - number of edges of v that do not lead to a winning position for Pe
+    uint32_t *queue[2]; //queue[e-1] - positions won by Pe whose predecessors have not been examined yet
+    uint32_t queueSize[2]; //number of positions in queue[e-1]
+} attractor;
+
+/**
+ * @brief a subset of the vertices of a game, seen as a game on its own
+ *
+ * The vertices of the subgame are numbered 0, ..., xn-1; local is both the membership mask and the global to local
+ * map. Owners and priorities are read from G, but the edges are copied: the edges of x that stay inside the subgame
+ * are targets[offsets[x]], ..., targets[offsets[x+1] - 1], in local numbering and in the order they have in G.
+ * Edges removed from G after copySubgame are still in the copy.
+ */
+typedef struct subgame {
+    const game *G; //the parent game
+    long *vertices; //vertices[x] - the vertex of G that x corresponds to
+    long xn; //number of vertices in the subgame
+    long *local; //local[v] - the position of v in vertices, -1 if v is not in the subgame
+    uint32_t *offsets; //xn+1 entries, offsets[x] - position of the first edge of x in targets
+    uint32_t *targets; //targets[i] - the local vertex edge i leads to
+    int *winner; //winner[x] - the player that has a winning strategy at x, 0 if not determined
+} subgame;
+
+/**
+ * @brief returns the largest of value[targets[j]] for first <= j < last, where first < last. This is the inner loop of
+ * the searches for obsolete edges; when compiled for AVX2 it gathers and compares four values at once
+ *
+ * @param value the values of the vertices
+ * @param targets the targets of the edges
+ * @param first the first edge
+ * @param last one after the last edge
+ * @return long long the largest value
+ */
+static inline long long largestTarget(const long long *value, const uint32_t *targets, uint32_t first, uint32_t last) {
+    long long best = value[targets[first]];
+    uint32_t j = first + 1;
+
+#ifdef __AVX2__
+    if(last - j >= 4) {
+        __m256i acc = _mm256_set1_epi64x(best), x;
+        long long lanes[4];
+
+        for(; j + 4 <= last; j += 4) {
+            x = _mm256_i32gather_epi64(value, _mm_loadu_si128((const __m128i *) (targets + j)), 8);
+            acc = _mm256_blendv_epi8(acc, x, _mm256_cmpgt_epi64(x, acc));
+        }
+        _mm256_storeu_si256((__m256i *) lanes, acc);
+        for(int l = 0; l < 4; l++) {
+            best = lanes[l] > best ? lanes[l] : best;
+        }
+    }
+#endif
+    for(; j < last; j++) {
+        best = value[targets[j]] > best ? value[targets[j]] : best;
+    }
+
+    return best;
+}
+
+/**
+ * @brief returns the smallest of value[targets[j]] for first <= j < last, where first < last, see largestTarget
+ *
+ * @param value the values of the vertices
+ * @param targets the targets of the edges
+ * @param first the first edge
+ * @param last one after the last edge
+ * @return long long the smallest value
+ */
+static inline long long smallestTarget(const long long *value, const uint32_t *targets, uint32_t first, uint32_t last) {
+    long long best = value[targets[first]];
+    uint32_t j = first + 1;
+
+#ifdef __AVX2__
+    if(last - j >= 4) {
+        __m256i acc = _mm256_set1_epi64x(best), x;
+        long long lanes[4];
+
+        for(; j + 4 <= last; j += 4) {
+            x = _mm256_i32gather_epi64(value, _mm_loadu_si128((const __m128i *) (targets + j)), 8);
+            acc = _mm256_blendv_epi8(acc, x, _mm256_cmpgt_epi64(acc, x));
+        }
+        _mm256_storeu_si256((__m256i *) lanes, acc);
+        for(int l = 0; l < 4; l++) {
+            best = lanes[l] < best ? lanes[l] : best;
+        }
+    }
+#endif
+    for(; j < last; j++) {
+        best = value[targets[j]] < best ? value[targets[j]] : best;
+    }
+
+    return best;
+}
+
+uint32_t liveEdges(const game *G, uint32_t *liveOffsets, uint32_t *liveTargets);
+void addEdge(edgeList *L, unsigned long v1, unsigned long v2);
+edge *mergeEdgeLists(edgeList *L, int count);
+long removeEdges(game *G, edge *F);
+long *reachingVertices(game *G, edge *F);
+void copySubgame(subgame *S, long *X, const game *G, long *local);
+void freeSubgame(subgame *S);
+void buildPredecessors(game *G, uint32_t *predOffsets, uint32_t *predSources, uint32_t *outDegree);
+attractor *newAttractor(game *G);
+void freeAttractor(attractor *A);
+void setWinner(attractor *A, int *W, uint32_t v, unsigned int e);
+void attract(attractor *A, int *W, unsigned int e);
+void reach(int *W, unsigned int e, game *G);
+long addSubsets(long **X, long r, game *G, long *local, sccShared *P);
+long *strConnComp(long *X, game *G, long *local, long *s);
 
 
 #endif
\ No newline at end of file
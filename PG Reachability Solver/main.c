@@ -20,7 +20,124 @@ void initSheet(lxw_worksheet *worksheet) {
 }
 
 
+/**
+ * @brief prints the command line options
+ * 
+ * @param name the name of the program
+ */
+void printUsage(char *name) {
+    printf("Usage: %s [options]\n", name);
+    printf("  --threads=N          number of threads used by the parallel parts of the solvers (default 1)\n");
+    printf("  --parallel-scc       split large subsets into strongly connected components in parallel\n");
+    printf("  --scc-threshold=N    subsets with fewer vertices are split sequentially (default 100000)\n");
+    printf("  --adaptive-k=K       search for obsolete edges on cycles of length K first, doubling K up to n\n");
+    printf("  --mpg-backend=B      mean payoff algorithm of PGSolver1: value (value iteration, default) or energy\n");
+    printf("  --sweep-threshold=N  value iteration rounds on subgames with fewer vertices use one thread (default 4096)\n");
+    printf("  --switch-policy=P    edges switched by strategy improvement: all-best (default), all-first, single-best,\n");
+    printf("                       random-edge, random-order, restricted-best or random-facet\n");
+    printf("  --improvement-threshold=N  strategy improvement on subgames with fewer vertices uses one thread\n");
+    printf("                       (default 4096)\n");
+}
+
+/**
+ * @brief sets the solver options from the command line
+ * 
+ * @param argc 
+ * @param argv 
+ * @return int 1 if all options were valid
+ */
+int parseOptions(int argc, char **argv) {
+    static struct option longOptions[] = {
+        {"threads", required_argument, NULL, 't'},
+        {"parallel-scc", no_argument, NULL, 'p'},
+        {"scc-threshold", required_argument, NULL, 's'},
+        {"adaptive-k", required_argument, NULL, 'k'},
+        {"mpg-backend", required_argument, NULL, 'm'},
+        {"sweep-threshold", required_argument, NULL, 'w'},
+        {"switch-policy", required_argument, NULL, 'i'},
+        {"improvement-threshold", required_argument, NULL, 'v'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+    int c;
+
+    while((c = getopt_long(argc, argv, "t:ps:k:m:w:i:v:h", longOptions, NULL)) != -1) {
+        switch(c) {
+            case 't':
+                options.threads = atoi(optarg);
+                if(options.threads < 1) {
+                    options.threads = 1;
+                }
+                break;
+            case 'p':
+                options.parallelScc = 1;
+                break;
+            case 's':
+                options.sccThreshold = atol(optarg);
+                break;
+            case 'k':
+                options.adaptiveK = atol(optarg);
+                break;
+            case 'm':
+                if(strcmp(optarg, "value") == 0) {
+                    options.mpgBackend = MPG_VALUE_ITERATION;
+                }
+                else if(strcmp(optarg, "energy") == 0) {
+                    options.mpgBackend = MPG_ENERGY;
+                }
+                else {
+                    printUsage(argv[0]);
+                    return 0;
+                }
+                break;
+            case 'w':
+                options.sweepThreshold = atol(optarg);
+                break;
+            case 'i':
+                if(strcmp(optarg, "all-best") == 0) {
+                    options.switchPolicy = SWITCH_ALL_BEST;
+                }
+                else if(strcmp(optarg, "all-first") == 0) {
+                    options.switchPolicy = SWITCH_ALL_FIRST;
+                }
+                else if(strcmp(optarg, "single-best") == 0) {
+                    options.switchPolicy = SWITCH_SINGLE_BEST;
+                }
+                else if(strcmp(optarg, "random-edge") == 0) {
+                    options.switchPolicy = SWITCH_RANDOM_EDGE;
+                }
+                else if(strcmp(optarg, "random-order") == 0) {
+                    options.switchPolicy = SWITCH_RANDOM_ORDER;
+                }
+                else if(strcmp(optarg, "restricted-best") == 0) {
+                    options.switchPolicy = SWITCH_RESTRICTED_BEST;
+                }
+                else if(strcmp(optarg, "random-facet") == 0) {
+                    options.switchPolicy = SWITCH_RANDOM_FACET;
+                }
+                else {
+                    printUsage(argv[0]);
+                    return 0;
+                }
+                break;
+            case 'v':
+                options.improvementThreshold = atol(optarg);
+                break;
+            default:
+                printUsage(argv[0]);
+                return 0;
+        }
+    }
+
+    return 1;
+}
+
+
 int main(int argc, char **argv) {
+    if(!parseOptions(argc, argv)) {
+        return EXIT_FAILURE;
+    }
+
     lxw_workbook *workbook = workbook_new("../Results/Results.xlsx");
     lxw_worksheet *worksheet = workbook_add_worksheet(workbook, NULL);
 
@@ -30,11 +147,11 @@ int main(int argc, char **argv) {
     int tCount = 0;
 
     
-    tCount = benchmarkTestSet("Keiren Tests", 1000, 10, 15, tCount, workbook, worksheet);
+    tCount = benchmarkTestSet("Keiren Tests", 1000, 10, 15, tCount, worksheet);
 
-    tCount = benchmarkTestSet("Random Tests", 1000, 10, 15, tCount, workbook, worksheet);
+    tCount = benchmarkTestSet("Random Tests", 1000, 10, 15, tCount, worksheet);
 
-    tCount = benchmarkTestSet("Bipartite Symmetric Tests", 1000, 10, 15, tCount, workbook, worksheet);
+    tCount = benchmarkTestSet("Bipartite Symmetric Tests", 1000, 10, 15, tCount, worksheet);
 
 
     printf("%d tests completed.\n", tCount);
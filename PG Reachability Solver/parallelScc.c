@@ -0,0 +1,685 @@
+#include "utilities.h"
+#include "graphFunctions.h"
+#include "parallelScc.h"
+
+/**
+ * @brief reads the partition of v; other threads may change the partition of vertices they own at the same time
+ *
+ * @param S the shared state
+ * @param v a vertex
+ * @return uint32_t the partition of v, 0 if v already has a component
+ */
+static inline uint32_t colorOf(sccShared *S, uint32_t v) {
+    return __atomic_load_n(&S->color[v], __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief moves v to another partition
+ *
+ * @param S the shared state
+ * @param v a vertex
+ * @param c the new partition, 0 once v has a component
+ */
+static inline void setColor(sccShared *S, uint32_t v, uint32_t c) {
+    __atomic_store_n(&S->color[v], c, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief reserves a range of component numbers
+ *
+ * @param S the shared state
+ * @param count number of components
+ * @return long the first reserved number
+ */
+static long reserveComponents(sccShared *S, long count) {
+    long first;
+
+    pthread_mutex_lock(&S->lock);
+    first = S->nextComp;
+    S->nextComp = S->nextComp + count;
+    pthread_mutex_unlock(&S->lock);
+
+    return first;
+}
+
+/**
+ * @brief adds the partition V to the tasks. Its vertices must already have the partition number c
+ *
+ * @param S the shared state
+ * @param V the vertices of the partition, freed by the thread that processes it
+ * @param k number of vertices in V
+ * @param c the partition number
+ */
+static void pushTask(sccShared *S, uint32_t *V, long k, uint32_t c) {
+    pthread_mutex_lock(&S->lock);
+    if(S->taskCount == S->taskCapacity) {
+        S->taskCapacity = S->taskCapacity * 2 + 16;
+        S->tasks = (sccTask *) realloc(S->tasks, S->taskCapacity * sizeof(sccTask));
+        verify_alloc(S->tasks);
+    }
+    S->tasks[S->taskCount].V = V;
+    S->tasks[S->taskCount].k = k;
+    S->tasks[S->taskCount].color = c;
+    S->taskCount++;
+    S->active++;
+    pthread_cond_signal(&S->wake);
+    pthread_mutex_unlock(&S->lock);
+}
+
+/**
+ * @brief returns a new partition number
+ *
+ * @param S the shared state
+ * @return uint32_t the partition number
+ */
+static uint32_t newColor(sccShared *S) {
+    return __atomic_add_fetch(&S->nextColor, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief splits a small partition with the sequential version of Tarjan's algorithm
+ *
+ * @param S the shared state
+ * @param V the vertices of the partition
+ * @param k number of vertices in V
+ * @param c the partition number
+ */
+static void tarjanTask(sccShared *S, uint32_t *V, long k, uint32_t c) {
+    game *G = S->G;
+    long *index = S->index; //index[v] - order in which v was visited, -1 if not yet
+    long *low = S->low; //low[v] - smallest index reachable from v among the vertices on the stack
+    long *comp = S->comp;
+    uint32_t *stack = (uint32_t *) malloc((k + 1) * sizeof(uint32_t));
+    uint32_t *callStack = (uint32_t *) malloc((k + 1) * sizeof(uint32_t));
+    uint32_t *nextEdge = (uint32_t *) malloc((k + 1) * sizeof(uint32_t)); //nextEdge[i] - the next edge to examine of callStack[i]
+    uint32_t *found = (uint32_t *) malloc((k + 1) * sizeof(uint32_t)); //the vertices in the order their components were completed
+    long *localComp = (long *) malloc((k + 1) * sizeof(long)); //component of found[i], numbered from 0 within this partition
+    long sp = 0, csp = 0, nFound = 0, s = 0, counter = 0, first, i;
+    uint32_t v, w, e;
+    int descended;
+    verify_alloc(stack);
+    verify_alloc(callStack);
+    verify_alloc(nextEdge);
+    verify_alloc(found);
+    verify_alloc(localComp);
+
+    for(i = 0; i < k; i++) {
+        index[V[i]] = -1;
+    }
+
+    for(i = 0; i < k; i++) {
+        if(index[V[i]] != -1) {
+            continue;
+        }
+
+        index[V[i]] = low[V[i]] = counter++;
+        stack[sp++] = V[i];
+        callStack[csp] = V[i];
+        nextEdge[csp] = G->offsets[V[i]];
+        csp++;
+
+        while(csp > 0) {
+            v = callStack[csp - 1];
+            descended = 0;
+
+            while(nextEdge[csp - 1] < G->offsets[v+1]) {
+                e = nextEdge[csp - 1];
+                nextEdge[csp - 1]++;
+                w = G->targets[e];
+                if(edgeDeleted(G, e) || colorOf(S, w) != c) {
+                    continue;
+                }
+                if(index[w] == -1) {
+                    index[w] = low[w] = counter++;
+                    stack[sp++] = w;
+                    callStack[csp] = w;
+                    nextEdge[csp] = G->offsets[w];
+                    csp++;
+                    descended = 1;
+                    break;
+                }
+                if(comp[w] == -1 && index[w] < low[v]) {
+                    //w is still on the stack
+                    low[v] = index[w];
+                }
+            }
+            if(descended) {
+                continue;
+            }
+
+            if(low[v] == index[v]) {
+                do {
+                    sp--;
+                    comp[stack[sp]] = -2; //the vertex is no longer on the stack
+                    found[nFound] = stack[sp];
+                    localComp[nFound] = s;
+                    nFound++;
+                }while(stack[sp] != v);
+                s++;
+            }
+            csp--;
+            if(csp > 0 && low[v] < low[callStack[csp - 1]]) {
+                low[callStack[csp - 1]] = low[v];
+            }
+        }
+    }
+
+    first = reserveComponents(S, s);
+    for(i = 0; i < nFound; i++) {
+        comp[found[i]] = first + localComp[i];
+        setColor(S, found[i], 0);
+    }
+
+    free(stack);
+    free(callStack);
+    free(nextEdge);
+    free(found);
+    free(localComp);
+}
+
+/**
+ * @brief marks every vertex of partition c that is reachable from the pivot (forward) or that reaches the pivot (backward)
+ *
+ * @param S the shared state
+ * @param pivot the first vertex
+ * @param c the partition number
+ * @param bit 1 for the forward search, 2 for the backward search
+ * @param queue room for all vertices of the partition
+ */
+static void colorSearch(sccShared *S, uint32_t pivot, uint32_t c, uint8_t bit, uint32_t *queue) {
+    game *G = S->G;
+    long qi, qmax = 0;
+    uint32_t v, w, i;
+
+    S->mark[pivot] |= bit;
+    queue[qmax++] = pivot;
+    for(qi = 0; qi < qmax; qi++) {
+        v = queue[qi];
+        if(bit == 1) {
+            for(i = G->offsets[v]; i < G->offsets[v+1]; i++) {
+                w = G->targets[i];
+                if(!edgeDeleted(G, i) && colorOf(S, w) == c && !(S->mark[w] & bit)) {
+                    S->mark[w] |= bit;
+                    queue[qmax++] = w;
+                }
+            }
+        }
+        else {
+            for(i = S->predOffsets[v]; i < S->predOffsets[v+1]; i++) {
+                w = S->predSources[i];
+                if(colorOf(S, w) == c && !(S->mark[w] & bit)) {
+                    S->mark[w] |= bit;
+                    queue[qmax++] = w;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief splits partition c: the vertices that reach the pivot and are reachable from it form a component,
+ * the rest is divided into three new partitions that are processed independently
+ *
+ * @param S the shared state
+ * @param V the vertices of the partition, freed here
+ * @param k number of vertices in V
+ * @param c the partition number
+ */
+static void processTask(sccShared *S, uint32_t *V, long k, uint32_t c) {
+    uint32_t *parts[3]; //forward only, backward only, neither
+    long size[3] = {0, 0, 0};
+    uint32_t colors[3];
+    long i, p, id;
+    uint32_t v;
+
+    if(k < S->threshold) {
+        tarjanTask(S, V, k, c);
+        free(V);
+        return;
+    }
+
+    uint32_t *queue = (uint32_t *) malloc((k + 1) * sizeof(uint32_t));
+    verify_alloc(queue);
+    colorSearch(S, V[0], c, 1, queue);
+    colorSearch(S, V[0], c, 2, queue);
+    free(queue);
+
+    for(p = 0; p < 3; p++) {
+        parts[p] = (uint32_t *) malloc((k + 1) * sizeof(uint32_t));
+        verify_alloc(parts[p]);
+        colors[p] = newColor(S);
+    }
+
+    id = reserveComponents(S, 1);
+    for(i = 0; i < k; i++) {
+        v = V[i];
+        switch(S->mark[v]) {
+            case 3:
+                S->comp[v] = id;
+                setColor(S, v, 0);
+                S->mark[v] = 0;
+                continue;
+            case 1:
+                p = 0;
+                break;
+            case 2:
+                p = 1;
+                break;
+            default:
+                p = 2;
+        }
+        S->mark[v] = 0;
+        setColor(S, v, colors[p]);
+        parts[p][size[p]++] = v;
+    }
+    free(V);
+
+    for(p = 0; p < 3; p++) {
+        if(size[p] > 0) {
+            pushTask(S, parts[p], size[p], colors[p]);
+        }
+        else free(parts[p]);
+    }
+}
+
+/**
+ * @brief takes partitions from the shared task list until every vertex has a component. Run once on every thread by
+ * parallelFor; a thread that finds no task waits for the partitions the other threads are still splitting
+ *
+ * @param i the number of the step, unused
+ * @param thread the number of the thread, unused
+ * @param arg the shared state
+ */
+static void sccWorker(long i, int thread, void *arg) {
+    sccShared *S = (sccShared *) arg;
+    sccTask task;
+    (void) i;
+    (void) thread;
+
+    pthread_mutex_lock(&S->lock);
+    while(1) {
+        while(S->taskCount == 0 && S->active > 0) {
+            pthread_cond_wait(&S->wake, &S->lock);
+        }
+        if(S->taskCount == 0) {
+            //no tasks are queued or running
+            pthread_cond_broadcast(&S->wake);
+            pthread_mutex_unlock(&S->lock);
+            return;
+        }
+        S->taskCount--;
+        task = S->tasks[S->taskCount];
+        pthread_mutex_unlock(&S->lock);
+
+        processTask(S, task.V, task.k, task.color);
+
+        pthread_mutex_lock(&S->lock);
+        S->active--;
+        if(S->active == 0) {
+            pthread_cond_broadcast(&S->wake);
+        }
+    }
+}
+
+/**
+ * @brief returns the number of steps of a parallel loop over count vertices in chunks of TRIM_CHUNK
+ */
+static long trimSteps(long count) {
+    return (count + TRIM_CHUNK - 1) / TRIM_CHUNK;
+}
+
+/**
+ * @brief removes v from the partition that is trimmed. Only the thread that changes the partition of v from 1 to 0
+ * adds it to the next round
+ *
+ * @param S the shared state
+ * @param v a vertex of the subset
+ */
+static void trimVertex(sccShared *S, uint32_t v) {
+    uint32_t expected = 1;
+
+    if(__atomic_compare_exchange_n(&S->color[v], &expected, 0, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        S->next[__atomic_fetch_add(&S->nextSize, 1, __ATOMIC_RELAXED)] = v;
+    }
+}
+
+/**
+ * @brief puts the vertices of one chunk of X in partition 1, the whole subset
+ *
+ * @param chunk the number of the chunk
+ * @param thread the number of the thread, unused
+ * @param arg the shared state
+ */
+static void trimStart(long chunk, int thread, void *arg) {
+    sccShared *S = (sccShared *) arg;
+    long end = ((chunk + 1) * TRIM_CHUNK < S->xn) ? (chunk + 1) * TRIM_CHUNK : S->xn;
+    uint32_t v;
+    (void) thread;
+
+    for(long x = chunk * TRIM_CHUNK; x < end; x++) {
+        v = S->X[x];
+        S->color[v] = 1;
+        S->inSubset[v] = 1;
+        S->comp[v] = -1;
+        S->inside[v] = 0;
+    }
+}
+
+/**
+ * @brief counts the edges that stay inside X for one chunk of X
+ *
+ * @param chunk the number of the chunk
+ * @param thread the number of the thread, unused
+ * @param arg the shared state
+ */
+static void trimCount(long chunk, int thread, void *arg) {
+    sccShared *S = (sccShared *) arg;
+    game *G = S->G;
+    long end = ((chunk + 1) * TRIM_CHUNK < S->xn) ? (chunk + 1) * TRIM_CHUNK : S->xn;
+    uint32_t v, w, i, out;
+    (void) thread;
+
+    for(long x = chunk * TRIM_CHUNK; x < end; x++) {
+        v = S->X[x];
+        out = 0;
+        for(i = G->offsets[v]; i < G->offsets[v+1]; i++) {
+            w = G->targets[i];
+            if(!edgeDeleted(G, i) && S->inSubset[w]) {
+                out++;
+                __atomic_fetch_add(&S->inside[w], 1, __ATOMIC_RELAXED);
+            }
+        }
+        S->outDegree[v] = out;
+    }
+}
+
+/**
+ * @brief trims the vertices of one chunk of X that have no incoming or no outgoing edges inside X
+ *
+ * @param chunk the number of the chunk
+ * @param thread the number of the thread, unused
+ * @param arg the shared state
+ */
+static void trimSeed(long chunk, int thread, void *arg) {
+    sccShared *S = (sccShared *) arg;
+    long end = ((chunk + 1) * TRIM_CHUNK < S->xn) ? (chunk + 1) * TRIM_CHUNK : S->xn;
+    (void) thread;
+
+    for(long x = chunk * TRIM_CHUNK; x < end; x++) {
+        if(S->outDegree[S->X[x]] == 0 || S->inside[S->X[x]] == 0) {
+            trimVertex(S, S->X[x]);
+        }
+    }
+}
+
+/**
+ * @brief gives the vertices of one chunk of the frontier their own components and removes their edges from the
+ * counts of their neighbours; the neighbours that lose their last edge in either direction are trimmed next
+ *
+ * @param chunk the number of the chunk
+ * @param thread the number of the thread, unused
+ * @param arg the shared state
+ */
+static void trimRound(long chunk, int thread, void *arg) {
+    sccShared *S = (sccShared *) arg;
+    game *G = S->G;
+    long end = ((chunk + 1) * TRIM_CHUNK < S->frontierSize) ? (chunk + 1) * TRIM_CHUNK : S->frontierSize;
+    uint32_t v, w, i;
+    (void) thread;
+
+    for(long f = chunk * TRIM_CHUNK; f < end; f++) {
+        v = S->frontier[f];
+        S->comp[v] = S->nextComp + f;
+        for(i = G->offsets[v]; i < G->offsets[v+1]; i++) {
+            w = G->targets[i];
+            if(!edgeDeleted(G, i) && colorOf(S, w) == 1 && __atomic_sub_fetch(&S->inside[w], 1, __ATOMIC_RELAXED) == 0) {
+                trimVertex(S, w);
+            }
+        }
+        for(i = S->predOffsets[v]; i < S->predOffsets[v+1]; i++) {
+            w = S->predSources[i];
+            if(colorOf(S, w) == 1 && __atomic_sub_fetch(&S->outDegree[w], 1, __ATOMIC_RELAXED) == 0) {
+                trimVertex(S, w);
+            }
+        }
+    }
+}
+
+/**
+ * @brief puts X in partition 1 and removes the vertices that have no incoming or no outgoing edges inside the
+ * partition, repeatedly; each of them is a component on its own. The rounds are split between the threads
+ *
+ * @param S the shared state, S->X and S->xn give the subset
+ * @return long number of vertices left in partition 1
+ */
+static long trim(sccShared *S) {
+    long left = S->xn;
+    uint32_t *swap;
+
+    parallelFor(trimSteps(S->xn), trimStart, S);
+    parallelFor(trimSteps(S->xn), trimCount, S);
+    S->nextSize = 0;
+    parallelFor(trimSteps(S->xn), trimSeed, S);
+
+    while(S->nextSize > 0) {
+        swap = S->frontier;
+        S->frontier = S->next;
+        S->next = swap;
+        S->frontierSize = S->nextSize;
+        S->nextSize = 0;
+        parallelFor(trimSteps(S->frontierSize), trimRound, S);
+        S->nextComp = S->nextComp + S->frontierSize;
+        left = left - S->frontierSize;
+    }
+
+    return left;
+}
+
+/**
+ * @brief orders the components found by the threads so that every component comes after all components it can reach
+ *
+ * @param S the shared state
+ * @param X the subset
+ * @param xn number of vertices in X
+ * @param s number of components
+ * @return long* comp[x] - the component of X[x], numbered from 1 in reverse topological order
+ */
+static long *orderComponents(sccShared *S, long *X, long xn, long s) {
+    game *G = S->G;
+    long *outEdges = (long *) calloc(s + 1, sizeof(long)); //outEdges[c] - number of edges from c to other components
+    long *inOffsets = (long *) calloc(s + 2, sizeof(long)); //the edges into component c come from inSources[inOffsets[c]], ...
+    long *inSources;
+    long *order = (long *) malloc((s + 1) * sizeof(long)); //order[c] - number of c in reverse topological order
+    long *queue = (long *) malloc((s + 1) * sizeof(long));
+    long *result = (long *) malloc((xn + 1) * sizeof(long));
+    long qi, qmax = 0, x, a, b;
+    uint32_t v, i;
+    verify_alloc(outEdges);
+    verify_alloc(inOffsets);
+    verify_alloc(order);
+    verify_alloc(queue);
+    verify_alloc(result);
+
+    //edges between components, as a graph on the components
+    for(x = 0; x < xn; x++) {
+        v = X[x];
+        for(i = G->offsets[v]; i < G->offsets[v+1]; i++) {
+            if(!edgeDeleted(G, i) && S->inSubset[G->targets[i]]) {
+                a = S->comp[v];
+                b = S->comp[G->targets[i]];
+                if(a != b) {
+                    outEdges[a]++;
+                    inOffsets[b + 1]++;
+                }
+            }
+        }
+    }
+    for(a = 0; a < s; a++) {
+        inOffsets[a + 1] = inOffsets[a + 1] + inOffsets[a];
+    }
+    inSources = (long *) malloc((inOffsets[s] + 1) * sizeof(long));
+    verify_alloc(inSources);
+    for(x = 0; x < xn; x++) {
+        v = X[x];
+        for(i = G->offsets[v]; i < G->offsets[v+1]; i++) {
+            if(!edgeDeleted(G, i) && S->inSubset[G->targets[i]]) {
+                a = S->comp[v];
+                b = S->comp[G->targets[i]];
+                if(a != b) {
+                    inSources[inOffsets[b]++] = a;
+                }
+            }
+        }
+    }
+    for(b = s; b > 0; b--) {
+        inOffsets[b] = inOffsets[b - 1];
+    }
+    inOffsets[0] = 0;
+
+    //components that cannot reach any other component come first
+    for(a = 0; a < s; a++) {
+        if(outEdges[a] == 0) {
+            queue[qmax++] = a;
+        }
+    }
+    for(qi = 0; qi < qmax; qi++) {
+        b = queue[qi];
+        order[b] = qi + 1;
+        for(i = inOffsets[b]; i < inOffsets[b + 1]; i++) {
+            a = inSources[i];
+            outEdges[a]--;
+            if(outEdges[a] == 0) {
+                queue[qmax++] = a;
+            }
+        }
+    }
+
+    for(x = 0; x < xn; x++) {
+        result[x] = order[S->comp[X[x]]];
+    }
+
+    free(outEdges);
+    free(inOffsets);
+    free(inSources);
+    free(order);
+    free(queue);
+
+    return result;
+}
+
+/**
+ * @brief creates the state of the parallel split into strongly connected components for a whole solve. The edges of
+ * G must not change while the state is used
+ *
+ * @param G the game
+ * @param predOffsets the predecessor lists of the live edges of G, see buildPredecessors; they are not copied
+ * @param predSources
+ * @return sccShared* the state
+ */
+sccShared *newSccState(game *G, uint32_t *predOffsets, uint32_t *predSources) {
+    sccShared *S = (sccShared *) calloc(1, sizeof(sccShared));
+    verify_alloc(S);
+
+    S->G = G;
+    S->predOffsets = predOffsets;
+    S->predSources = predSources;
+    S->color = (uint32_t *) calloc(G->n + 1, sizeof(uint32_t));
+    S->inSubset = (uint8_t *) calloc(G->n + 1, sizeof(uint8_t));
+    S->mark = (uint8_t *) calloc(G->n + 1, sizeof(uint8_t));
+    S->comp = (long *) malloc((G->n + 1) * sizeof(long));
+    S->index = (long *) malloc((G->n + 1) * sizeof(long));
+    S->low = (long *) malloc((G->n + 1) * sizeof(long));
+    S->outDegree = (uint32_t *) malloc((G->n + 1) * sizeof(uint32_t));
+    S->inside = (uint32_t *) malloc((G->n + 1) * sizeof(uint32_t));
+    S->frontier = (uint32_t *) malloc((G->n + 1) * sizeof(uint32_t));
+    S->next = (uint32_t *) malloc((G->n + 1) * sizeof(uint32_t));
+    verify_alloc(S->color);
+    verify_alloc(S->inSubset);
+    verify_alloc(S->mark);
+    verify_alloc(S->comp);
+    verify_alloc(S->index);
+    verify_alloc(S->low);
+    verify_alloc(S->outDegree);
+    verify_alloc(S->inside);
+    verify_alloc(S->frontier);
+    verify_alloc(S->next);
+    pthread_mutex_init(&S->lock, NULL);
+    pthread_cond_init(&S->wake, NULL);
+
+    return S;
+}
+
+/**
+ * @brief frees the state of the parallel split into strongly connected components, but not the predecessor lists
+ *
+ * @param S the state
+ */
+void freeSccState(sccShared *S) {
+    pthread_mutex_destroy(&S->lock);
+    pthread_cond_destroy(&S->wake);
+    free(S->color);
+    free(S->inSubset);
+    free(S->mark);
+    free(S->comp);
+    free(S->index);
+    free(S->low);
+    free(S->outDegree);
+    free(S->inside);
+    free(S->frontier);
+    free(S->next);
+    free(S->tasks);
+    free(S);
+}
+
+/**
+ * @brief find the strongly connected components of the subgraph of G with the nodes from X using several threads.
+ * Vertices without incoming or outgoing edges are trimmed first, then the forward-backward algorithm splits the rest
+ * into independent partitions; partitions smaller than options.sccThreshold are split with Tarjan's algorithm.
+ * Both phases run on the threads of parallelFor
+ *
+ * @param X the subset of nodes which we need to split
+ * @param S the state made by newSccState for the game
+ * @param s number of strongly connected components of the subgraph G with the nodes from X
+ * @return long* comp[x] - the strongly connected component X[x] belongs to, numbered from 1 in reverse topological
+ * order, like strConnComp
+ */
+long *parallelStrConnComp(long *X, sccShared *S, long *s) {
+    long xn = 0, x, k;
+    long *result;
+    uint32_t *V;
+
+    while(X[xn] >= 0) {
+        xn++;
+    }
+
+    S->threshold = options.sccThreshold;
+    S->X = X;
+    S->xn = xn;
+    S->nextColor = 1; //partition 1 is the whole subset
+    S->nextComp = 0;
+    S->taskCount = 0;
+    S->active = 0;
+
+    k = trim(S);
+    if(k > 0) {
+        V = (uint32_t *) malloc((k + 1) * sizeof(uint32_t));
+        verify_alloc(V);
+        k = 0;
+        for(x = 0; x < xn; x++) {
+            if(S->color[X[x]] == 1) {
+                V[k++] = X[x];
+            }
+        }
+        pushTask(S, V, k, 1);
+        parallelFor(options.threads, sccWorker, S);
+    }
+
+    *s = S->nextComp;
+    result = orderComponents(S, X, xn, *s);
+
+    for(x = 0; x < xn; x++) {
+        S->inSubset[X[x]] = 0;
+    }
+
+    return result;
+}
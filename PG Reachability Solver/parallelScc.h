@@ -0,0 +1,55 @@
+#ifndef PARALLELSCC_H_INCLUDED
+#define PARALLELSCC_H_INCLUDED
+
+#include "utilities.h"
+
+/**
+ * @brief a partition of the subset whose strongly connected components are not known yet
+ */
+typedef struct sccTask {
+    uint32_t *V; //the vertices of the partition
+    long k; //number of vertices in V
+    uint32_t color; //the partition number of the vertices in V
+} sccTask;
+
+#define TRIM_CHUNK 1024 //number of vertices in one step of the parallel trim
+
+/**
+ * @brief the state of the parallel split into strongly connected components. It is made once per solve, like the
+ * attractor state, and shared by the threads that split a subset. Between two calls of parallelStrConnComp every vertex
+ * has partition 0, mark 0 and inSubset 0
+ */
+typedef struct sccShared {
+    game *G; //the game
+    long threshold; //partitions smaller than this are split with Tarjan's algorithm
+    uint32_t *predOffsets; //the predecessors of w are predSources[predOffsets[w]], ..., predSources[predOffsets[w+1] - 1]
+    uint32_t *predSources; //both belong to the attractor state of the solve
+    uint32_t *color; //color[v] - the partition v belongs to, 0 if v is outside the subset or already has a component
+    uint8_t *inSubset; //inSubset[v] - 1 if v belongs to the subset
+    uint8_t *mark; //mark[v] - bit 1 if v was reached by the forward search, bit 2 by the backward search
+    long *comp; //comp[v] - the component of v, numbered in the order they were found
+    long *index; //scratch arrays of Tarjan's algorithm
+    long *low;
+    uint32_t *outDegree; //outDegree[v] - number of edges of v that lead to vertices of the subset that are not trimmed
+    uint32_t *inside; //inside[v] - number of edges into v from vertices of the subset that are not trimmed
+    long *X; //the subset that is split
+    long xn; //number of vertices in X
+    uint32_t *frontier; //the vertices trimmed in the last round of trim, they have no components yet
+    long frontierSize;
+    uint32_t *next; //the vertices trimmed in the current round of trim
+    long nextSize;
+    uint32_t nextColor; //the last partition number handed out
+    long nextComp; //number of components found so far
+    sccTask *tasks; //the partitions waiting for a thread
+    long taskCount;
+    long taskCapacity;
+    long active; //number of partitions that are queued or being processed
+    pthread_mutex_t lock; //protects tasks, taskCount, active and nextComp
+    pthread_cond_t wake; //signalled when a task is added or the last one is done
+} sccShared;
+
+sccShared *newSccState(game *G, uint32_t *predOffsets, uint32_t *predSources);
+void freeSccState(sccShared *S);
+long *parallelStrConnComp(long *X, sccShared *S, long *s);
+
+#endif
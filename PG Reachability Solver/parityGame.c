@@ -0,0 +1,162 @@
+#include "utilities.h"
+#include "parityGame.h"
+
+/**
+ * @brief allocates a game with n vertices and m edges. Owners, priorities and edges are left to the caller, no edge is removed
+ *
+ * @param n number of vertices
+ * @param m number of edges
+ * @return game* the allocated game
+ */
+game *newGame(uint32_t n, uint32_t m) {
+    game *G = (game *) malloc(sizeof(game));
+    verify_alloc(G);
+
+    G->n = n;
+    G->m = m;
+    G->owner = (uint8_t *) malloc((n+1) * sizeof(uint8_t));
+    G->priority = (uint32_t *) malloc((n+1) * sizeof(uint32_t));
+    G->offsets = (uint32_t *) malloc((n+1) * sizeof(uint32_t));
+    G->targets = (uint32_t *) malloc((m+1) * sizeof(uint32_t));
+    G->deleted = (uint64_t *) calloc(m/64 + 1, sizeof(uint64_t));
+    verify_alloc(G->owner);
+    verify_alloc(G->priority);
+    verify_alloc(G->offsets);
+    verify_alloc(G->targets);
+    verify_alloc(G->deleted);
+
+    G->offsets[0] = 0;
+    G->mapping = NULL;
+    G->mappingSize = 0;
+    G->shared = 0;
+
+    return G;
+}
+
+/**
+ * @brief frees a game and all of its arrays
+ *
+ * @param G the game
+ */
+void freeGame(game *G) {
+    if(G == NULL) {
+        return;
+    }
+    if(G->shared) {
+        //the arrays belong to another game
+    }
+    else if(G->mapping != NULL) {
+        //the arrays belong to the mapped file
+        munmap(G->mapping, G->mappingSize);
+    }
+    else {
+        free(G->owner);
+        free(G->priority);
+        free(G->offsets);
+        free(G->targets);
+    }
+    free(G->deleted);
+    free(G);
+}
+
+/**
+ * @brief returns a game with the vertices and edges of G and its own copy of the removed edges. G is not changed by
+ * removing edges from the new game, and must not be freed before it
+ *
+ * @param G the game
+ * @return game* a game that shares the arrays of G
+ */
+game *shareGame(const game *G) {
+    game *D = (game *) malloc(sizeof(game));
+    verify_alloc(D);
+
+    *D = *G;
+    D->deleted = (uint64_t *) malloc((G->m/64 + 1) * sizeof(uint64_t));
+    verify_alloc(D->deleted);
+    memcpy(D->deleted, G->deleted, (G->m/64 + 1) * sizeof(uint64_t));
+    D->mapping = NULL;
+    D->mappingSize = 0;
+    D->shared = 1;
+
+    return D;
+}
+
+/**
+ * @brief removes edge e from the game by marking it in the deleted bitmap
+ *
+ * @param G the game
+ * @param e the edge index
+ */
+void removeEdge(game *G, uint32_t e) {
+    G->deleted[e >> 6] |= (uint64_t) 1 << (e & 63);
+}
+
+/**
+ * @brief orders priorities increasingly; used with qsort
+ */
+static int comparePriorities(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *) a;
+    uint32_t y = *(const uint32_t *) b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief renumbers the priorities of G densely without changing the winner of any vertex. The distinct priorities are
+ * taken in increasing order; a priority with the same parity as the previous one gets the same new value, otherwise
+ * the next value. The order and the parity of the priorities are kept, so the largest priority of every cycle keeps
+ * its parity, and the maximum priority becomes at most the number of parity changes
+ *
+ * @param G the game, its priorities are replaced
+ * @return uint32_t the new maximum priority
+ */
+uint32_t compressPriorities(game *G) {
+    uint32_t *sorted = (uint32_t *) malloc((G->n + 1) * sizeof(uint32_t)); //the distinct priorities, increasing
+    uint32_t *value = (uint32_t *) malloc((G->n + 1) * sizeof(uint32_t)); //value[i] - the new value of sorted[i]
+    uint32_t distinct = 0, lo, hi, mid, v;
+    verify_alloc(sorted);
+    verify_alloc(value);
+
+    if(G->n == 0) {
+        free(sorted);
+        free(value);
+        return 0;
+    }
+
+    memcpy(sorted, G->priority, G->n * sizeof(uint32_t));
+    qsort(sorted, G->n, sizeof(uint32_t), comparePriorities);
+    for(v = 0; v < G->n; v++) {
+        if(distinct == 0 || sorted[v] != sorted[distinct - 1]) {
+            sorted[distinct] = sorted[v];
+            distinct++;
+        }
+    }
+
+    value[0] = sorted[0] % 2;
+    for(v = 1; v < distinct; v++) {
+        if(sorted[v] % 2 == sorted[v - 1] % 2) {
+            value[v] = value[v - 1];
+        }
+        else value[v] = value[v - 1] + 1;
+    }
+
+    for(v = 0; v < G->n; v++) {
+        //binary search for the position of the priority of v
+        lo = 0;
+        hi = distinct - 1;
+        while(lo < hi) {
+            mid = lo + (hi - lo) / 2;
+            if(sorted[mid] < G->priority[v]) {
+                lo = mid + 1;
+            }
+            else hi = mid;
+        }
+        G->priority[v] = value[lo];
+    }
+
+    v = value[distinct - 1];
+    free(sorted);
+    free(value);
+
+    return v;
+}
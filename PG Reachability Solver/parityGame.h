@@ -0,0 +1,44 @@
+#ifndef PARITYGAME_H_INCLUDED
+#define PARITYGAME_H_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief a parity game stored in compressed sparse row form
+ *
+ * The outgoing edges of v are targets[offsets[v]], ..., targets[offsets[v+1] - 1].
+ * Edge e has been removed from the game if bit e of deleted is set. A game made by shareGame uses the vertices and
+ * edges of another game and only has its own removed edges, so solvers can remove edges without copying the input.
+ */
+typedef struct game {
+    uint32_t n; //number of vertices
+    uint32_t m; //number of edges
+    uint8_t *owner; //owner[v] - player that owns v (1 or 2)
+    uint32_t *priority; //priority[v] - omega(v)
+    uint32_t *offsets; //n+1 entries, offsets[v] - position of the first outgoing edge of v in targets
+    uint32_t *targets; //targets[e] - the vertex edge e leads to
+    uint64_t *deleted; //bitmap of the removed edges
+    void *mapping; //if not NULL, owner, priority, offsets and targets point into this memory mapped file
+    size_t mappingSize; //size of the mapped file
+    int shared; //1 if owner, priority, offsets and targets belong to another game
+} game;
+
+game *newGame(uint32_t n, uint32_t m);
+void freeGame(game *G);
+game *shareGame(const game *G);
+void removeEdge(game *G, uint32_t e);
+uint32_t compressPriorities(game *G);
+
+/**
+ * @brief returns 1 if edge e has been removed from the game
+ *
+ * @param G the game
+ * @param e the edge index
+ * @return int 1 if e was removed, 0 otherwise
+ */
+static inline int edgeDeleted(const game *G, uint32_t e) {
+    return (G->deleted[e >> 6] >> (e & 63)) & 1;
+}
+
+#endif
@@ -3,16 +3,17 @@
 
 
 /**
- * @brief Solves the parity game stored in G by using mean payoff games
+ * @brief Solves the parity game stored in G by using mean payoff games. G is not changed
  * 
- * @param G the graph with all the parity game information; G[x][0] - owner of node x; G[x][1] - priority of x; G[x][k] > -1, k > 1, (x, G[x][k]) is an edge 
- * @param n number of nodes of the graph
+ * @param G the game
  * @return int* W[x] - the player that has a winning positional strategy at vertex x
  */
-int *pgSolver1(long **G, long n) {
-    int M = maxOmega(G, n);
-    long long *mu = getMu(G, n, M);
-    int *W = mpgSolver(G, n, mu, M);
+int *pgSolver1(const game *G) {
+    int M = maxOmega(G);
+    mpgWeight *mu = getMu(G, M);
+    game *H = shareGame(G); //the obsolete edges are removed from H
+    int *W = mpgSolver(H, mu);
+    freeGame(H);
     free(mu);
     return W;
 }
@@ -20,64 +21,105 @@ int *pgSolver1(long **G, long n) {
 /**
  * @brief Get the array of edge weights in the mean payoff game
  * 
- * @param G the graph with all the parity game information; G[x][0] - owner of node x; G[x][1] - priority of x; G[x][k] > -1, k > 1, (x, G[x][k]) is an edge 
- * @param n number of nodes in the graph
+ * @param G the game
  * @param M the largest priority in the graph
- * @return long long* for all edges (x, y) in the equivalent mpg have the weight mu[x]
+ * @return mpgWeight* for all edges (x, y) in the equivalent mpg have the weight mu[x]
  */
-long long *getMu(long **G, long n, long M) {
-    long long *mu;
-    mu = (long long *) malloc(n * sizeof(long long));
+mpgWeight *getMu(const game *G, long M) {
+    long n = G->n;
+    mpgWeight *mu;
+    mpgWeight *powers = (mpgWeight *) malloc((M+1) * sizeof(mpgWeight)); //powers[p] - (-n)^p
+    mu = (mpgWeight *) malloc(n * sizeof(mpgWeight));
     verify_alloc(mu);
+    verify_alloc(powers);
+    powers[0] = 1;
+    for(long p=1; p<=M; p++) {
+        powers[p] = weightMul(powers[p-1], -n);
+    }
     for(long i=0; i<n; i++) {
-        mu[i] = power(-n, G[i][1]);
+        mu[i] = powers[G->priority[i]];
     }
+    free(powers);
     return mu;
 }
 
+/**
+ * @brief returns 1 if the mean payoff game of a game with n vertices and maximum priority M can be solved exactly with
+ * mpgWeight. The values of the value iteration can exceed the range, but once a value reaches MPG_INF it is already
+ * decided; a value that took an infinite value from a neighbour is at most (4n+1)N below it and a chain of such values
+ * has at most n links, so 8n^2 N < MPG_INF is enough for every decision to be the same as with unbounded integers
+ *
+ * @param n number of vertices
+ * @param M the maximum priority
+ * @return int 1 if the weights fit
+ */
+int mpgWeightsFit(long n, int M) {
+    mpgWeight N = 1; //n^M, the largest weight
+
+    for(int p = 1; p <= M; p++) {
+        N = weightMul(N, n);
+    }
+
+    return weightMul(weightMul(8 * n, n), N) != MPG_INF;
+}
+
 /**
  * @brief Solves the equivalent mean payoff game of G
  * 
- * @param G the graph with all the parity game information; G[x][0] - owner of node x; G[x][1] - priority of x; G[x][k] > -1, k > 1, (x, G[x][k]) is an edge 
- * @param n number of nodes in the graph
+ * @param G the game
  * @param mu for all edges (x, y) in the equivalent mpg have the weight mu[x]
- * @param M the maximum priority in G
  * @return int* W[x] - the player that has a winning positional strategy at node x
  */
-int *mpgSolver(long ** G, long n, long long *mu, int M) {
+int *mpgSolver(game *G, mpgWeight *mu) {
+    long n = G->n;
     long r; //number of subsets left to solve
     long *newXr; //a subset that is obtained from removing all vertices with known winners from X[r]
     long xn; //number of vertices in a subset
     int *W = (int *) malloc (n * sizeof(int)); //W[x] - the player that has a winning positional strategy at node x
     long **X = (long **) malloc ((n+1) * sizeof(long *)); //Array of subsets
-    edge *F; //array of n-obsolete edges
-    long **C; //The graph formed from the subset X[r], also contains the winners of each node
-
-    F = mpgObsolete(n, G, n, mu, M); //find all n-obsolete edges
-    while(F[0].v1 != -1) { 
-        //After removing all n-obsolete edges in the graph, more n-obsolete edges may be discovered
-        //We keep removing n-obsolete edges until no more are found
-        long k = 0;
-        long i;
-        long j;
-        while (F[k].v1 != -1) {
-            i = F[k].v1;
-            j = 2;
-            while(G[i][j] != F[k].v2) {
-                j++;
+    edge *F; //array of k-obsolete edges
+    long k; //the maximum length of the cycles of the obsolete edges
+    long *sources; //the vertices that are examined in the next search for obsolete edges, all if NULL
+    subgame S; //the subgame formed from the subset X[r], also contains the winners of each node
+    attractor *A; //the attractor state of both players, kept for the whole loop
+    long *local; //scratch array for addSubsets, local[v] = -1 outside of it
+    sccShared *P = NULL; //the state of the parallel split into strongly connected components, kept for the whole loop
+
+    //After removing all k-obsolete edges in the graph, more k-obsolete edges may be discovered
+    //We keep removing k-obsolete edges until no more are found, then try longer cycles until k = n
+    //Only the sources that can reach a removed edge can have new obsolete edges, the others are not examined again
+    k = (options.adaptiveK > 0 && options.adaptiveK < n) ? options.adaptiveK : n;
+    sources = NULL; //all vertices
+    while(1) {
+        F = mpgObsolete(k, G, mu, sources); //find all k-obsolete edges
+        free(sources);
+        if(F[0].v1 == (unsigned long) -1) {
+            free(F);
+            if(k >= n) {
+                break;
             }
-            G[i][j] = -1; //Remove the n-obsolete edge
-            k++;
+            k = (2 * k < n) ? 2 * k : n;
+            sources = NULL;
+            continue;
         }
+        sources = reachingVertices(G, F);
+        removeEdges(G, F); //Remove the k-obsolete edges
         free(F);
-        F = mpgObsolete(n, G, n, mu, M);
     }
-    free(F);
 
     //initialize the W array
     for(long i=0; i<n; i++) {
         W[i] = 0; 
     }
+    A = newAttractor(G);
+    if(options.parallelScc && options.threads > 1) {
+        P = newSccState(G, A->predOffsets, A->predSources);
+    }
+    local = (long *) malloc((n+1) * sizeof(long));
+    verify_alloc(local);
+    for(long i=0; i<n; i++) {
+        local[i] = -1;
+    }
 
     if(n == 0) {
         r = 0;
@@ -118,253 +160,544 @@ int *mpgSolver(long ** G, long n, long long *mu, int M) {
         newXr[xn] = -2;
         X[r] = newXr;
 
-        r = addSubsets(X, r, G, n); //add all the strongly connected components of X[r] to X
+        r = addSubsets(X, r, G, local, P); //add all the strongly connected components of X[r] to X
 
-        C = mpgSubgraphSolver(X[r], G, n, mu); //solve the mpg of subgraph X[r]
-        for(long i=0; X[r][i] > -2; i++) {
-            W[C[i][1]] = C[i][0]; //store the winners of the nodes in X[r]
-            free(C[i]);
+        copySubgame(&S, X[r], G, local);
+        //solve the mpg of subgraph X[r]
+        if(options.mpgBackend == MPG_ENERGY) {
+            mpgEnergySolver(&S, mu);
+        }
+        else mpgSubgraphSolver(&S, mu);
+        for(long i=0; i < S.xn; i++) {
+            if(S.winner[i] != 0) {
+                setWinner(A, W, S.vertices[i], S.winner[i]); //store the winners of the nodes in X[r]
+            }
         }
-        free(C);
+        freeSubgame(&S);
         free(X[r]);
         r--;
 
-        reach(W, 1, G, n); //play the reachability game for P1
-        reach(W, 2, G, n); //play the reachability game for P2
+        //play the reachability games, starting from the positions that were just decided
+        attract(A, W, 1); //play the reachability game for P1
+        attract(A, W, 2); //play the reachability game for P2
     }
 
     free(X);
+    if(P != NULL) {
+        freeSccState(P);
+    }
+    freeAttractor(A);
+    free(local);
 
     return W;
 
 }
 
 /**
- * @brief creates an array of the k-obsolete edges of the graph
+ * @brief finds the k-obsolete edges that leave the vertex v. Called by mpgObsolete for every vertex, on any thread.
+ * The inner loops only read dense arrays and need no allocation. With 64 bit weights the best value over the edges of
+ * a vertex is found by largestTarget and smallestTarget
  * 
- * @param k the maximum length of the cycle
- * @param G the graph with all the parity game information; G[x][0] - owner of node x; G[x][1] - priority of x; G[x][k] > -1, k > 1, (x, G[x][k]) is an edge 
- * @param n number of nodes in the graph
- * @param mu the array of edge weights
- * @param M the maximum omega value of the graph
- * @return edge* the array of k-obsolete edges
+ * @param x the position of the source vertex in P->sources, or the source vertex if P->sources is NULL
+ * @param thread the thread that runs the search; its buffers and list of edges are used
+ * @param arg the mpgObsoleteSearch
  */
-edge* mpgObsolete(long k, long **G, long n, long long *mu, int M) {
-    edge *F; //array of k-obsolete edges
-    long sizeF = n; //size of F
-    F = (edge *) malloc (sizeF * sizeof(edge));
-    verify_alloc(F);
-    long idxF = 0; //smallest empty position in the F array
-    int e; //epsilon(v)
-    long long inf = LLONG_MAX - 1; //infinity
-    long long max; 
+void mpgObsoleteSource(long x, int thread, void *arg) {
+    mpgObsoleteSearch *P = (mpgObsoleteSearch *) arg;
+    long v = (P->sources != NULL) ? P->sources[x] : x; //the source vertex
+    game *G = P->G;
+    mpgWeight *mu = P->mu;
+    long n = G->n;
+    const int8_t *sign = P->sign;
+    const uint32_t *offsets = P->liveOffsets;
+    const uint32_t *targets = P->liveTargets;
+    int e = sign[v]; //epsilon(v)
+    mpgWeight *eta = P->eta[thread]; //eta_i-1
+    mpgWeight *nextEta = P->nextEta[thread]; //eta_i
+    mpgWeight *swap;
+    mpgWeight inf = MPG_INF; //infinity
+    mpgWeight best; 
     long u;
-    int hasOutgoingEdges;
+    int changed; //1 if eta_i differs from eta_i-1
 
-    for(long v=0; v < n; v++) {
-        e = epsilon(G, v);
-        long long *eta = (long long *) malloc (n * sizeof(long long));
-        verify_alloc(eta);
+    //initialize eta_0
+    for(long w = 0; w < n; w++) {
+        eta[w] = e * inf;
+    }
+    eta[v] = 0;
 
-        //initialize eta_0
+    for(long i = 1; i < P->k; i++) {
+        changed = 0;
         for(long w = 0; w < n; w++) {
-            if(w == v) {
-                eta[w] = 0;
+            if(offsets[w] == offsets[w+1]) {
+                //if it has no outgoing edges, it is a sink
+                nextEta[w] = e * inf;
+                continue;
             }
-            else eta[w] = e * inf;
+
+            //finding the best available outgoing edge at w: the largest value for P2, the smallest for P1
+#ifdef MPG_INT128_WEIGHTS
+            best = eta[targets[offsets[w]]];
+            if(sign[w] > 0) {
+                for(uint32_t j = offsets[w] + 1; j < offsets[w+1]; j++) {
+                    best = eta[targets[j]] > best ? eta[targets[j]] : best;
+                }
+            }
+            else {
+                for(uint32_t j = offsets[w] + 1; j < offsets[w+1]; j++) {
+                    best = eta[targets[j]] < best ? eta[targets[j]] : best;
+                }
+            }
+#else
+            best = (sign[w] > 0) ? largestTarget(eta, targets, offsets[w], offsets[w+1])
+                : smallestTarget(eta, targets, offsets[w], offsets[w+1]);
+#endif
+
+            nextEta[w] = weightAdd(best, mu[w]); //stays infinite if best is infinite
+            changed |= (nextEta[w] != eta[w]) && (w != v);
         }
-        
+        nextEta[v] = 0; //eta_x[v] = 0 for all x
 
-        for(long i = 1; i < k; i++) {
-            long long *nextEta = (long long *) malloc (n * sizeof(long long));
-            verify_alloc(nextEta);
+        //replace eta_i-1 with eta_i
+        swap = eta;
+        eta = nextEta;
+        nextEta = swap;
 
-            for(long w = 0; w < n; w++) {
-                if(w == v) {
-                    nextEta[w] = 0; //eta_x[v] = 0 for all x
-                    continue;
-                }
+        if(!changed) {
+            //eta_i = eta_i-1, so all further rounds give the same values
+            break;
+        }
+    }
+    for(uint32_t i = offsets[v]; i < offsets[v+1]; i++) {
+        u = targets[i];
+        if(e * eta[u] < -e * mu[v]) {
+            //it is an obsolete edge, so we add it to the list of the thread
+            addEdge(&P->found[thread], v, u);
+        }
+    }
+}
+
+/**
+ * @brief creates an array of the k-obsolete edges of the graph. The vertices are examined on options.threads threads
+ * 
+ * @param k the maximum length of the cycle
+ * @param G the game
+ * @param mu the array of edge weights
+ * @param sources the source vertices whose edges are examined, ending with -2; all vertices if NULL
+ * @return edge* the array of k-obsolete edges
+ */
+edge* mpgObsolete(long k, game *G, mpgWeight *mu, long *sources) {
+    long n = G->n;
+    int threads = options.threads;
+    mpgObsoleteSearch P;
+    edge *F; //array of k-obsolete edges
+    long count; //number of source vertices
+
+    P.k = k;
+    P.G = G;
+    P.sources = sources;
+    P.mu = mu;
+    P.sign = (int8_t *) malloc((n+1) * sizeof(int8_t));
+    P.liveOffsets = (uint32_t *) malloc((n+1) * sizeof(uint32_t));
+    P.liveTargets = (uint32_t *) malloc((G->m + 1) * sizeof(uint32_t));
+    P.eta = (mpgWeight **) malloc(threads * sizeof(mpgWeight *));
+    P.nextEta = (mpgWeight **) malloc(threads * sizeof(mpgWeight *));
+    P.found = (edgeList *) calloc(threads, sizeof(edgeList));
+    verify_alloc(P.sign);
+    verify_alloc(P.liveOffsets);
+    verify_alloc(P.liveTargets);
+    verify_alloc(P.eta);
+    verify_alloc(P.nextEta);
+    verify_alloc(P.found);
+    for(int t = 0; t < threads; t++) {
+        P.eta[t] = (mpgWeight *) malloc((n+1) * sizeof(mpgWeight));
+        P.nextEta[t] = (mpgWeight *) malloc((n+1) * sizeof(mpgWeight));
+        verify_alloc(P.eta[t]);
+        verify_alloc(P.nextEta[t]);
+    }
+    for(long w = 0; w < n; w++) {
+        P.sign[w] = epsilon(G, w);
+    }
+    liveEdges(G, P.liveOffsets, P.liveTargets);
 
-                hasOutgoingEdges = 0;
+    count = n;
+    if(sources != NULL) {
+        count = 0;
+        while(sources[count] >= 0) {
+            count++;
+        }
+    }
+    parallelFor(count, mpgObsoleteSource, &P);
 
-                //finding the best available outgoing edge at w
-                for (long j= 2; G[w][j] > -2; j++) {
-                    if(G[w][j] > -1) {
-                        u = G[w][j];
-                        if(hasOutgoingEdges == 0) {
-                            hasOutgoingEdges = 1;
-                            max = epsilon(G, w) * eta[u];
+    F = mergeEdgeLists(P.found, threads);
+    for(int t = 0; t < threads; t++) {
+        free(P.eta[t]);
+        free(P.nextEta[t]);
+    }
+    free(P.eta);
+    free(P.nextEta);
+    free(P.found);
+    free(P.sign);
+    free(P.liveOffsets);
+    free(P.liveTargets);
 
-                        } else if(epsilon(G, w) * eta[u] > max) {
-                            max = epsilon(G, w) * eta[u];
-                        }
-                    }
-                }
+    return F;
+}
 
-                if(!hasOutgoingEdges) {
-                    //if it has no outgoing edges, it is a sink
-                    nextEta[w] = e * inf;
-                    continue;
-                }
 
-                
-                
-               if(max != -inf && max != inf) {
-                    nextEta[w] = epsilon(G, w) * max + mu[w];
+/**
+ * @brief computes one round of the value iteration for the nodes of chunk c and the statistics of the chunk. Called by
+ * parallelFor for every chunk, on any thread
+ *
+ * @param c the number of the chunk
+ * @param thread the number of the thread, not needed since every chunk has its own statistics
+ * @param arg the mpgSweep
+ */
+void mpgSweepChunk(long c, int thread, void *arg) {
+    mpgSweep *P = (mpgSweep *) arg;
+    (void) thread;
+    const uint32_t *offsets = P->offsets;
+    const uint32_t *targets = P->targets;
+    const mpgWeight *weight = P->weight;
+    const int8_t *sign = P->sign;
+    const mpgWeight *nu = P->nu;
+    mpgWeight *newNu = P->newNu;
+    int *winner = P->winner;
+    mpgWeight threshold = P->threshold;
+    mpgWeight best, change;
+    mpgWeight minChange = MPG_INF;
+    mpgWeight maxChange = -MPG_INF;
+    long decided = 0;
+    int finite = 1;
+    uint32_t i;
+
+    for(long x = P->chunkStart[c]; x < P->chunkStart[c+1]; x++) {
+        best = nu[targets[offsets[x]]];
+        if(sign[x] == -1) {
+            //P1 wants to minimize the sum
+            for(i = offsets[x] + 1; i < offsets[x+1]; i++) {
+                if(nu[targets[i]] < best) {
+                    best = nu[targets[i]];
                 }
-                else nextEta[w] = epsilon(G, w) * max;
-
-                
             }
-
-            free(eta);
-            eta = nextEta; //replace eta_i-1 with eta_i
         }
-        for(long i= 2; G[v][i] > -2; i++) {
-            if(G[v][i] > -1) {
-                u = G[v][i];
-                if(e * eta[u] < -e * mu[v]) {
-                    //it is an obsolete edge, so we add it to the array
-                    if(idxF == sizeF) {
-                        sizeF = sizeF * 2;
-                        F = (edge *) realloc(F, sizeF * sizeof(edge));
-                        verify_alloc(F);
-                    }
-                    F[idxF].v1 = v;
-                    F[idxF].v2 = u;
-                    idxF++;
+        else {
+            //P2 wants to maximize the sum
+            for(i = offsets[x] + 1; i < offsets[x+1]; i++) {
+                if(nu[targets[i]] > best) {
+                    best = nu[targets[i]];
                 }
             }
         }
-        free(eta);
-    }
+        newNu[x] = weightAdd(weight[x], best);
+
+        if(winner[x] == 0) {
+            if(newNu[x] > threshold) {
+                winner[x] = 2; //P2 has a winning strategy at x
+                decided++;
+            }
+            else if(newNu[x] < -threshold) {
+                winner[x] = 1; //P1 has a winning strategy at x
+                decided++;
+            }
+        }
 
-    //we add one final element to the array, to signal the end of it
-    if(idxF == sizeF) {
-        sizeF = sizeF + 1;
-        F = (edge *) realloc(F, sizeF * sizeof(edge));
+        if(newNu[x] == MPG_INF || newNu[x] == -MPG_INF || nu[x] == MPG_INF || nu[x] == -MPG_INF) {
+            finite = 0;
+            continue;
+        }
+        change = newNu[x] - nu[x];
+        if(change < minChange) {
+            minChange = change;
+        }
+        if(change > maxChange) {
+            maxChange = change;
+        }
     }
-    F[idxF].v1 = -1;
-    F[idxF].v2 = -1;
 
-    return F;
+    P->decided[c] = decided;
+    P->minChange[c] = minChange;
+    P->maxChange[c] = maxChange;
+    P->finite[c] = finite;
 }
 
-
 /**
- * @brief determines the player with a winning positional strategy in the mean payoff game for the nodes in X
- * 
- * @param X subset of nodes of G
- * @param G the graph with all the parity game information; G[x][0] - owner of node x; G[x][1] - priority of x; G[x][k] > -1, k > 1, (x, G[x][k]) is an edge 
- * @param n number of nodes of the graph
- * @param mu the array of edge weights
- * @return long** the subgraph with the nodes of X, also stores the winners of each node
+ * @brief combines the statistics of all chunks after a round, makes the new values the current ones and decides if
+ * the value iteration is over. The value iteration stops when every node has a known winner, or when one round changed
+ * the value of every node by at least c > 0 (or at most c < 0): then each later round does the same and P2 (or P1)
+ * wins at all nodes. If no value changed, no later round changes anything either.
+ *
+ * @param P the value iteration
+ * @return int 1 if the value iteration is over
  */
-long **mpgSubgraphSolver(long *X, long **G, long n, long long *mu) {
-    long xn = 0; //number of nodes in X
-    long x, i, j, l;
-    long v, w;
-    long **C; //the subgraph with the nodes of X, X[v][0] = winner at x, X[v][1] = corresponding node in G
+int mpgSweepDone(mpgSweep *P) {
+    mpgWeight minChange = MPG_INF;
+    mpgWeight maxChange = -MPG_INF;
+    int finite = 1;
+    mpgWeight *swap;
+
+    for(int c = 0; c < P->chunks; c++) {
+        P->totalDecided += P->decided[c];
+        if(P->minChange[c] < minChange) {
+            minChange = P->minChange[c];
+        }
+        if(P->maxChange[c] > maxChange) {
+            maxChange = P->maxChange[c];
+        }
+        finite &= P->finite[c];
+    }
+    swap = P->nu;
+    P->nu = P->newNu;
+    P->newNu = swap;
 
-    while(X[xn] >= 0) {
-        xn++;
+    if(P->totalDecided == P->xn) {
+        return 1;
+    }
+    if(finite && (minChange > 0 || maxChange < 0)) {
+        //every later round moves every value in the same direction, so that player wins at all nodes
+        for(long x = 0; x < P->xn; x++) {
+            if(P->winner[x] == 0) {
+                P->winner[x] = (minChange > 0) ? 2 : 1;
+            }
+        }
+        return 1;
+    }
+    if(finite && minChange == 0 && maxChange == 0) {
+        return 1; //nu is a fixed point
     }
 
+    return 0;
+}
 
-    C = (long **) malloc(xn * sizeof(long *)); 
+/**
+ * @brief determines the player with a winning positional strategy in the mean payoff game for the nodes of the subgame
+ *
+ * The value iteration runs for at most 4n^2 N + 1 rounds and stops early as described in mpgSweepDone. On subgames with
+ * at least options.sweepThreshold nodes, the nodes of each round are split into one chunk per thread, with about the
+ * same number of edges in every chunk, and the chunks of a round are run by parallelFor. If some nodes are still undecided at the end, the subgame is solved with
+ * mpgEnergySolver instead, so no node is left out of both winning regions.
+ * 
+ * @param S the subgame, its winners are filled in
+ * @param mu the array of edge weights
+ */
+void mpgSubgraphSolver(subgame *S, mpgWeight *mu) {
+    const game *G = S->G;
+    long n = G->n;
+    long xn = S->xn; //number of nodes in the subgame
+    long x;
+    long v = S->vertices[0];
+    mpgSweep P;
 
     if(xn == 1) {
-        C[0] = (long *) malloc(3 * sizeof(long));
-        i=2;
-        while(G[X[0]][i] != -2 && G[X[0]][i] != X[0]) {
-            i++;
-        }
-        if(G[X[0]][i] != -2) {
-            C[0][0] = 2 - (G[X[0]][1] % 2); //this subgraph consists of a node with an edge to itself
-        } else if(G[X[0]][0] == 2) {
-            C[0][0] = 1; //this node is a sink, player that owns it loses at this position
-        } else C[0][0] = 2;
-        C[0][1] = X[0];
-        C[0][2] = -2;
-        return C;
+        if(S->offsets[1] > 0) {
+            S->winner[0] = 2 - (G->priority[v] % 2); //this subgraph consists of a node with an edge to itself
+        } else if(G->owner[v] == 2) {
+            S->winner[0] = 1; //this node is a sink, player that owns it loses at this position
+        } else S->winner[0] = 2;
+        return;
     }
 
+    P.xn = xn;
+    P.offsets = S->offsets;
+    P.targets = S->targets;
+    P.winner = S->winner;
+    P.chunks = (options.threads > 1 && xn >= options.sweepThreshold) ? options.threads : 1;
+    P.weight = (mpgWeight *) malloc(xn * sizeof(mpgWeight));
+    P.sign = (int8_t *) malloc(xn * sizeof(int8_t));
+    P.nu = (mpgWeight *) malloc(xn * sizeof(mpgWeight));
+    P.newNu = (mpgWeight *) malloc(xn * sizeof(mpgWeight));
+    P.chunkStart = (long *) malloc((P.chunks + 1) * sizeof(long));
+    P.decided = (long *) malloc(P.chunks * sizeof(long));
+    P.minChange = (mpgWeight *) malloc(P.chunks * sizeof(mpgWeight));
+    P.maxChange = (mpgWeight *) malloc(P.chunks * sizeof(mpgWeight));
+    P.finite = (int *) malloc(P.chunks * sizeof(int));
+    verify_alloc(P.weight);
+    verify_alloc(P.sign);
+    verify_alloc(P.nu);
+    verify_alloc(P.newNu);
+    verify_alloc(P.chunkStart);
+    verify_alloc(P.decided);
+    verify_alloc(P.minChange);
+    verify_alloc(P.maxChange);
+    verify_alloc(P.finite);
+
+    mpgWeight N = 0; //the largest value from the moduls of all edge weights
     for(x = 0; x < xn; x++) {
-        v = X[x];
-        C[x] = (long *) malloc((xn+3) * sizeof(long));
-        C[x][0] = 0; //no winner determined yet
-        C[x][1] = v; //the vertex of G which x corresponds to
-        //add all outgoing edges of v which lead to another node in X
-        l=2;
-        for(i = 2; G[v][i] > -2; i++) {
-            if(G[v][i] > -1) {
-                for(j = 0; j < xn; j++) {
-                    if(X[j] == G[v][i]) {
-                        C[x][l] = j;
-                        l++;
-                    }
-                }
-            }
+        v = S->vertices[x];
+        P.weight[x] = mu[v];
+        P.sign[x] = epsilon(G, v);
+        P.nu[x] = 0; //initialize nu
+        if(P.weight[x] > N) {
+            N = P.weight[x];
+        }
+        if(-P.weight[x] > N) {
+            N = -P.weight[x];
+        }
+    }
+    P.threshold = weightMul(2 * n, N); //a value above 2nN decides the game for P2, below -2nN for P1
+    P.rounds = weightAdd(weightMul(4 * n * n, N), 1); //number of rounds of the value iteration
+    P.totalDecided = 0;
+
+    //chunk c takes the nodes whose edges start after c/chunks of all edges of the subgame
+    x = 0;
+    for(int c = 0; c < P.chunks; c++) {
+        while(x < xn && (double) S->offsets[x] < (double) S->offsets[xn] * c / P.chunks) {
+            x++;
         }
-        C[x][l] = -2;
+        P.chunkStart[c] = x;
     }
+    P.chunkStart[P.chunks] = xn;
 
-    long long N = modulus(mu[C[0][1]]); //the largest value from the moduls of all edge weights
-    for(x = 1; x < xn; x++) {
-        if(modulus(mu[C[x][1]]) > N) {
-            N = modulus(mu[C[x][1]]);
+    //parallelFor returns when every chunk of the round is done, so the rounds never overlap
+    for(mpgWeight k = 1; k <= P.rounds; k++) {
+        parallelFor(P.chunks, mpgSweepChunk, &P);
+        if(mpgSweepDone(&P)) {
+            break;
         }
     }
 
-    long long *nu; //nu[x] - value of the k-step game that starts at x
-    long long *newNu; //newNu[x] - value of the (k+1)-step game that starts at x
-    long long min, max;
-    nu = (long long *) malloc(xn * sizeof(long long));
+    //the value iteration can end with undecided nodes only if some cycle has weight 0, which the weights of a parity
+    //game never give; the energy game decides every node in that case as well
+    x = 0;
+    while(x < xn && S->winner[x] != 0) {
+        x++;
+    }
+    if(x < xn) {
+        mpgEnergySolver(S, mu);
+    }
+
+    free(P.weight);
+    free(P.sign);
+    free(P.nu);
+    free(P.newNu);
+    free(P.chunkStart);
+    free(P.decided);
+    free(P.minChange);
+    free(P.maxChange);
+    free(P.finite);
+}
+
+/**
+ * @brief determines the player with a winning positional strategy in the mean payoff game for the nodes of the subgame,
+ * using the equivalent energy game and the small energy progress measure algorithm of Brim et al.
+ *
+ * f[x] is the smallest initial energy P2 needs at x to keep the sum of the weights from becoming negative, or MPG_INF
+ * if no energy is enough. A node is lifted to the energy its best (for P2) or worst (for P1) successor requires, and
+ * only the predecessors of a lifted node are examined again. A finite value above the sum of all negative weights means
+ * the energy can never be enough. Every cycle of the mean payoff game of a parity game has a non-zero weight, so P2
+ * wins exactly at the nodes with a finite f.
+ *
+ * @param S the subgame, its winners are filled in
+ * @param mu the array of edge weights
+ */
+void mpgEnergySolver(subgame *S, mpgWeight *mu) {
+    const game *G = S->G;
+    long xn = S->xn; //number of nodes in the subgame
+    const uint32_t *offsets = S->offsets;
+    const uint32_t *targets = S->targets;
+    long x, y, head, tail;
+    uint32_t i;
+    mpgWeight bound = 0; //the sum of all negative weights in the subgame, the largest finite energy
+    mpgWeight best, need;
+
+    mpgWeight *weight = (mpgWeight *) malloc(xn * sizeof(mpgWeight)); //weight[x] - mu of the x-th node
+    int8_t *sign = (int8_t *) malloc(xn * sizeof(int8_t)); //sign[x] - epsilon of the x-th node
+    mpgWeight *f = (mpgWeight *) malloc(xn * sizeof(mpgWeight)); //the progress measure
+    uint32_t *predOffsets = (uint32_t *) calloc(xn + 1, sizeof(uint32_t)); //the reversed edges of the subgame
+    uint32_t *predSources = (uint32_t *) malloc((offsets[xn] + 1) * sizeof(uint32_t));
+    long *queue = (long *) malloc(xn * sizeof(long)); //the nodes that may need to be lifted, a circular queue
+    char *queued = (char *) malloc(xn * sizeof(char)); //queued[x] - 1 if x is in the queue
+    verify_alloc(weight);
+    verify_alloc(sign);
+    verify_alloc(f);
+    verify_alloc(predOffsets);
+    verify_alloc(predSources);
+    verify_alloc(queue);
+    verify_alloc(queued);
 
-    //initialize nu
     for(x = 0; x < xn; x++) {
-        nu[x] = 0;
-    }
-
-    for(long long k = 1; k <= 4 * n * n * N +1; k++) {
-        newNu = (long long *) malloc(xn * sizeof(long long));
-        for(x = 0; x < xn; x++) {
-            v = C[x][1];
-            if(epsilon(G, v) == -1) {
-                //P1 wants to minimize the sum
-                min = nu[C[x][2]];
-                for(i = 3; C[x][i] >= 0; i++) {
-                    if(nu[C[x][i]] < min) {
-                        min = nu[C[x][i]];
-                    }
+        weight[x] = mu[S->vertices[x]];
+        sign[x] = epsilon(G, S->vertices[x]);
+        if(weight[x] < 0) {
+            bound = weightAdd(bound, -weight[x]);
+        }
+        f[x] = 0;
+        queue[x] = x;
+        queued[x] = 1;
+    }
+
+    //predOffsets[y+1] counts the edges into y first, then becomes the position after the last of them
+    for(i = 0; i < offsets[xn]; i++) {
+        predOffsets[targets[i] + 1]++;
+    }
+    for(y = 0; y < xn; y++) {
+        predOffsets[y+1] += predOffsets[y];
+    }
+    for(x = 0; x < xn; x++) {
+        for(i = offsets[x]; i < offsets[x+1]; i++) {
+            predSources[predOffsets[targets[i]]++] = x;
+        }
+    }
+    for(y = xn; y > 0; y--) {
+        predOffsets[y] = predOffsets[y-1];
+    }
+    predOffsets[0] = 0;
+
+    head = 0;
+    tail = 0; //the queue is full: all nodes are in it
+    long size = xn; //number of nodes in the queue
+    while(size > 0) {
+        x = queue[head];
+        head = (head + 1 == xn) ? 0 : head + 1;
+        size--;
+        queued[x] = 0;
+        if(f[x] == MPG_INF) {
+            continue;
+        }
+
+        //the energy needed at x: P2 picks the successor that needs the least, P1 the one that needs the most
+        if(offsets[x] == offsets[x+1]) {
+            best = (sign[x] == 1) ? MPG_INF : 0; //the owner of a sink loses
+        }
+        else {
+            best = f[targets[offsets[x]]];
+            for(i = offsets[x] + 1; i < offsets[x+1]; i++) {
+                if((sign[x] == 1) ? (f[targets[i]] < best) : (f[targets[i]] > best)) {
+                    best = f[targets[i]];
                 }
-                newNu[x] = mu[v] + min;
             }
-            else {
-                //P2 wants to maximize the sum
-                max = nu[C[x][2]];
-                for(i = 3; C[x][i] >= 0; i++) {
-                    if(nu[C[x][i]] > max) {
-                        max = nu[C[x][i]];
-                    }
+        }
+        need = weightAdd(best, -weight[x]);
+        if(need < 0) {
+            need = 0;
+        }
+        if(need > bound) {
+            need = MPG_INF;
+        }
+
+        if(need > f[x]) {
+            f[x] = need;
+            for(i = predOffsets[x]; i < predOffsets[x+1]; i++) {
+                y = predSources[i];
+                if(!queued[y] && f[y] != MPG_INF) {
+                    queued[y] = 1;
+                    queue[tail] = y;
+                    tail = (tail + 1 == xn) ? 0 : tail + 1;
+                    size++;
                 }
-                newNu[x] = mu[v] + max;
-            }
-            if(newNu[x] > 2 * n * N) {
-                C[x][0] = 2; //P2 has a winning strategy at x
-            }
-            if(newNu[x] < -2 * n * N) {
-                C[x][0] = 1; //P1 has a winning strategy at x
             }
         }
-        free(nu);
-        nu = newNu;
     }
 
-    free(nu);
+    for(x = 0; x < xn; x++) {
+        S->winner[x] = (f[x] == MPG_INF) ? 1 : 2;
+    }
 
-    return C;
+    free(weight);
+    free(sign);
+    free(f);
+    free(predOffsets);
+    free(predSources);
+    free(queue);
+    free(queued);
 }
-
-
-
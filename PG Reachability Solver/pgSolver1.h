@@ -2,12 +2,108 @@
 #define PGSOLVER1_H_INCLUDED
 
 #include "graphFunctions.h"
- 
 
-int *pgSolver1(long **G, long n);
-int *mpgSolver(long ** G, long n, long long *mu, int M);
-long long *getMu(long **G, long n, long M);
-edge* mpgObsolete(long k, long **G, long n, long long *mu, int M);
-long **mpgSubgraphSolver(long *X, long **G, long n, long long *mu);
+//The weights of the mean payoff game grow as n^M. Compiling with -DMPG_INT128_WEIGHTS stores them in 128 bits
+#ifdef MPG_INT128_WEIGHTS
+typedef __int128 mpgWeight;
+#define MPG_WEIGHT_MAX ((mpgWeight) (((unsigned __int128) 1 << 127) - 1))
+#else
+typedef long long mpgWeight;
+#define MPG_WEIGHT_MAX ((mpgWeight) LLONG_MAX)
+#endif
+#define MPG_INF (MPG_WEIGHT_MAX - 1) //infinity; a sum that does not fit in mpgWeight becomes MPG_INF or -MPG_INF
+
+/**
+ * @brief returns a + b. If one of them is infinite the sum is infinite too, and a sum that does not fit becomes
+ * infinite instead of wrapping around
+ *
+ * @param a a weight
+ * @param b a weight
+ * @return mpgWeight a + b
+ */
+static inline mpgWeight weightAdd(mpgWeight a, mpgWeight b) {
+    mpgWeight s;
+
+    if(a == MPG_INF || a == -MPG_INF) {
+        return a;
+    }
+    if(b == MPG_INF || b == -MPG_INF) {
+        return b;
+    }
+    if(__builtin_add_overflow(a, b, &s) || s >= MPG_INF || s <= -MPG_INF) {
+        return (a > 0) ? MPG_INF : -MPG_INF;
+    }
+
+    return s;
+}
+
+/**
+ * @brief returns a * b, or an infinite weight with the sign of the product if it does not fit
+ *
+ * @param a a weight
+ * @param b a weight
+ * @return mpgWeight a * b
+ */
+static inline mpgWeight weightMul(mpgWeight a, mpgWeight b) {
+    mpgWeight p;
+
+    if(__builtin_mul_overflow(a, b, &p) || p >= MPG_INF || p <= -MPG_INF) {
+        return ((a > 0) == (b > 0)) ? MPG_INF : -MPG_INF;
+    }
+
+    return p;
+}
+
+/**
+ * @brief the state of a search for k-obsolete edges, shared by the threads of mpgObsolete
+ */
+typedef struct mpgObsoleteSearch {
+    long k; //the maximum length of the cycle
+    game *G; //the game
+    long *sources; //the source vertices that are examined, all vertices if NULL
+    mpgWeight *mu; //the array of edge weights
+    int8_t *sign; //sign[w] - epsilon(w)
+    uint32_t *liveOffsets; //the edges of G that have not been removed, see liveEdges
+    uint32_t *liveTargets;
+    mpgWeight **eta; //eta[t], nextEta[t] - the two value arrays of thread t
+    mpgWeight **nextEta;
+    edgeList *found; //found[t] - the obsolete edges found by thread t
+} mpgObsoleteSearch;
+
+/**
+ * @brief the state of the value iteration of mpgSubgraphSolver. Every round, parallelFor computes the new values of the
+ * nodes from chunkStart[c] to chunkStart[c+1] - 1 and the statistics of each chunk c, then the calling thread combines
+ * them
+ */
+typedef struct mpgSweep {
+    long xn; //number of nodes in the subgame
+    const uint32_t *offsets; //the local edges of the subgame
+    const uint32_t *targets;
+    mpgWeight *weight; //weight[x] - mu of the x-th node
+    int8_t *sign; //sign[x] - epsilon of the x-th node
+    mpgWeight *nu; //nu[x] - value of the k-step game that starts at x
+    mpgWeight *newNu; //newNu[x] - value of the (k+1)-step game that starts at x
+    int *winner; //the winners of the subgame
+    mpgWeight threshold; //a value above it decides the game for P2, below -threshold for P1
+    mpgWeight rounds; //the largest number of rounds
+    int chunks; //number of chunks, one per thread
+    long *chunkStart; //chunks + 1 entries, the nodes of each chunk
+    long *decided; //decided[c] - number of nodes chunk c found a winner for in this round
+    mpgWeight *minChange; //minChange[c], maxChange[c] - the range of newNu[x] - nu[x] in chunk c
+    mpgWeight *maxChange;
+    int *finite; //finite[c] - 1 if no value in chunk c is infinite
+    long totalDecided; //number of nodes with a known winner
+} mpgSweep;
+
+int *pgSolver1(const game *G);
+int *mpgSolver(game *G, mpgWeight *mu);
+mpgWeight *getMu(const game *G, long M);
+int mpgWeightsFit(long n, int M);
+void mpgObsoleteSource(long x, int thread, void *arg);
+edge* mpgObsolete(long k, game *G, mpgWeight *mu, long *sources);
+void mpgSweepChunk(long c, int thread, void *arg);
+int mpgSweepDone(mpgSweep *P);
+void mpgSubgraphSolver(subgame *S, mpgWeight *mu);
+void mpgEnergySolver(subgame *S, mpgWeight *mu);
 
 #endif
\ No newline at end of file
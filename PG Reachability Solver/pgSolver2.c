@@ -9,244 +9,256 @@
  * @param n an integer value
  * @param t a vertex
  * @param inf a stand-in for infinity
- * @param G the graph
+ * @param G the game
  * @return int n or -n
  */
-int phi(int n, int t, int inf, long **G) {
-    if(n == inf || n == -inf) {
-        return epsilon(G, t) * n;
-    }
-
-    if(n % 2 == 1) {
-        return -n;
-    } 
-
-    return n;
+int phi(int n, int t, int inf, game *G) {
+    return phiSigned(n, epsilon(G, t), inf);
 }
 
 /**
- * @brief creates an array of the k-obsolete edges of the graph
+ * @brief finds the k-obsolete edges that leave the vertex v. Called by pgObsolete for every vertex, on any thread.
+ * Every round first applies phi to all values, then takes the best value over the live edges of each vertex, so the
+ * inner loops only read dense arrays and need no allocation, and the best value is found by largestTarget and
+ * smallestTarget
  * 
- * @param k the maximum length of the cycle
- * @param G the graph with all the parity game information; G[x][0] - owner of node x; G[x][1] - priority of x; G[x][k] > -1, k > 1, (x, G[x][k]) is an edge 
- * @param n number of nodes in the graph
- * @param mu the array of edge weights
- * @param M the maximum omega value of the graph
- * @return edge* the array of k-obsolete edges
+ * @param x the position of the source vertex in P->sources, or the source vertex if P->sources is NULL
+ * @param thread the thread that runs the search; its buffers and list of edges are used
+ * @param arg the pgObsoleteSearch
  */
-edge* pgObsolete(long k, long **G, long n) {
-    edge *F; //array of k-obsolete edges
-    long sizeF = n; //size of F
-    F = (edge *) malloc (sizeF * sizeof(edge));
-    verify_alloc(F);
-    long idxF = 0; //smallest empty position in the F array
-    int e; //epsilon(v)
-    int inf = INT_MAX - 1; //infinity
-    int max; 
+void pgObsoleteSource(long x, int thread, void *arg) {
+    pgObsoleteSearch *P = (pgObsoleteSearch *) arg;
+    long v = (P->sources != NULL) ? P->sources[x] : x; //the source vertex
+    game *G = P->G;
+    long n = G->n;
+    const int8_t *sign = P->sign;
+    const uint32_t *offsets = P->liveOffsets;
+    const uint32_t *targets = P->liveTargets;
+    long *eta = P->eta[thread]; //eta_i-1
+    long *nextEta = P->nextEta[thread]; //eta_i
+    long long *phiEta = P->phiEta[thread]; //phiEta[u] - phi(eta_i-1[u])
+    long *swap;
+    long inf = INT_MAX - 1; //infinity
+    int ev = sign[v]; //epsilon(v), phi depends on it for the infinite values
+    long best, value, max;
     long u;
-    int hasOutgoingEdges;
+    int changed; //1 if eta_i differs from eta_i-1
 
-    for(long v=0; v < n; v++) {
-        e = epsilon(G, v);
-        long *eta = (long *) malloc (n * sizeof(long));
-        verify_alloc(eta);
+    //initialize eta_0
+    for(long w = 0; w < n; w++) {
+        eta[w] = inf;
+    }
+    eta[v] = 0;
 
-        //initialize eta_0
-        for(long w = 0; w < n; w++) {
-            if(w == v) {
-                eta[w] = 0;
-            }
-            else eta[w] = inf;
+    for(long i = 1; i < P->k; i++) {
+        for(u = 0; u < n; u++) {
+            phiEta[u] = phiSigned(eta[u], ev, inf);
         }
-        
 
-        for(long i = 1; i < k; i++) {
-            long *nextEta = (long *) malloc (n * sizeof(long));
-            verify_alloc(nextEta);
-
-            for(long w = 0; w < n; w++) {
-                if(w == v) {
-                    nextEta[w] = 0; //eta_x[v] = 0 for all x
-                    continue;
-                }
-
-                hasOutgoingEdges = 0;
+        changed = 0;
+        for(long w = 0; w < n; w++) {
+            if(offsets[w] == offsets[w+1]) {
+                //if it has no outgoing edges, it is a sink
+                nextEta[w] = inf;
+                continue;
+            }
 
-                //finding the best available outgoing edge at w
-                for (long j= 2; G[w][j] > -2; j++) {
-                    if(G[w][j] > -1) {
-                        u = G[w][j];
-                        if(hasOutgoingEdges == 0) {
-                            hasOutgoingEdges = 1;
-                            max = epsilon(G, w) * phi(eta[u], v, inf, G);
+            //finding the best available outgoing edge at w: the largest phi for P2, the smallest for P1
+            if(sign[w] > 0) {
+                best = largestTarget(phiEta, targets, offsets[w], offsets[w+1]);
+            }
+            else {
+                best = -smallestTarget(phiEta, targets, offsets[w], offsets[w+1]);
+            }
 
-                        } else if(epsilon(G, w) * phi(eta[u], v, inf, G) > max) {
-                            max = epsilon(G, w) * phi(eta[u], v, inf, G);
-                        }
-                    }
-                }
+            value = sign[w] * phiSigned(best, ev, inf);
+            nextEta[w] = (long) G->priority[w] > value ? (long) G->priority[w] : value;
+            changed |= (nextEta[w] != eta[w]) && (w != v);
+        }
+        nextEta[v] = 0; //eta_x[v] = 0 for all x
 
-                if(!hasOutgoingEdges) {
-                    //if it has no outgoing edges, it is a sink
-                    nextEta[w] = inf;
-                    continue;
-                }
+        //replace eta_i-1 with eta_i
+        swap = eta;
+        eta = nextEta;
+        nextEta = swap;
 
-                
-                
-               if(G[w][1] > epsilon(G, w) * phi(max, v, inf, G)) {
-                    nextEta[w] = G[w][1];
-               }
-               else nextEta[w] = epsilon(G, w) * phi(max, v, inf, G);
+        if(!changed) {
+            //eta_i = eta_i-1, so all further rounds give the same values
+            break;
+        }
+    }
+    for(uint32_t i = offsets[v]; i < offsets[v+1]; i++) {
+        u = targets[i];
+        if(eta[u] > G->priority[v]) {
+            max = eta[u];
+        }
+        else max = G->priority[v];
+        if(eta[u] != inf && max % 2 != G->owner[v] % 2) {
+            //it is an obsolete edge, so we add it to the list of the thread
+            addEdge(&P->found[thread], v, u);
+        }
+    }
+}
 
-                
-            }
+/**
+ * @brief creates an array of the k-obsolete edges of the graph. The vertices are examined on options.threads threads
+ * 
+ * @param k the maximum length of the cycle
+ * @param G the game
+ * @param sources the source vertices whose edges are examined, ending with -2; all vertices if NULL
+ * @return edge* the array of k-obsolete edges
+ */
+edge* pgObsolete(long k, game *G, long *sources) {
+    long n = G->n;
+    int threads = options.threads;
+    pgObsoleteSearch P;
+    edge *F; //array of k-obsolete edges
+    long count; //number of source vertices
+
+    P.k = k;
+    P.G = G;
+    P.sources = sources;
+    P.sign = (int8_t *) malloc((n+1) * sizeof(int8_t));
+    P.liveOffsets = (uint32_t *) malloc((n+1) * sizeof(uint32_t));
+    P.liveTargets = (uint32_t *) malloc((G->m + 1) * sizeof(uint32_t));
+    P.eta = (long **) malloc(threads * sizeof(long *));
+    P.nextEta = (long **) malloc(threads * sizeof(long *));
+    P.phiEta = (long long **) malloc(threads * sizeof(long long *));
+    P.found = (edgeList *) calloc(threads, sizeof(edgeList));
+    verify_alloc(P.sign);
+    verify_alloc(P.liveOffsets);
+    verify_alloc(P.liveTargets);
+    verify_alloc(P.eta);
+    verify_alloc(P.nextEta);
+    verify_alloc(P.phiEta);
+    verify_alloc(P.found);
+    for(int t = 0; t < threads; t++) {
+        P.eta[t] = (long *) malloc((n+1) * sizeof(long));
+        P.nextEta[t] = (long *) malloc((n+1) * sizeof(long));
+        P.phiEta[t] = (long long *) malloc((n+1) * sizeof(long long));
+        verify_alloc(P.eta[t]);
+        verify_alloc(P.nextEta[t]);
+        verify_alloc(P.phiEta[t]);
+    }
+    for(long w = 0; w < n; w++) {
+        P.sign[w] = epsilon(G, w);
+    }
+    liveEdges(G, P.liveOffsets, P.liveTargets);
 
-            free(eta);
-            eta = nextEta; //replace eta_i-1 with eta_i
+    count = n;
+    if(sources != NULL) {
+        count = 0;
+        while(sources[count] >= 0) {
+            count++;
         }
-        for(long i= 2; G[v][i] > -2; i++) {
-            if(G[v][i] > -1) {
-                u = G[v][i];
-                if(eta[u] > G[v][1]) {
-                    max = eta[u];
-                }
-                else max = G[v][1];
-                if(eta[u] != inf && max % 2 != G[v][0] % 2) {
-                    //it is an obsolete edge, so we add it to the array
-                    if(idxF == sizeF) {
-                        sizeF = sizeF * 2;
-                        F = (edge *) realloc(F, sizeF * sizeof(edge));
-                        verify_alloc(F);
-                    }
-                    F[idxF].v1 = v;
-                    F[idxF].v2 = u;
-                    idxF++;
-                }
-            }
-        }
-        free(eta);
     }
+    parallelFor(count, pgObsoleteSource, &P);
 
-    //we add one final element to the array, to signal the end of it
-    if(idxF == sizeF) {
-        sizeF = sizeF + 1;
-        F = (edge *) realloc(F, sizeF * sizeof(edge));
+    F = mergeEdgeLists(P.found, threads);
+    for(int t = 0; t < threads; t++) {
+        free(P.eta[t]);
+        free(P.nextEta[t]);
+        free(P.phiEta[t]);
     }
-    F[idxF].v1 = -1;
-    F[idxF].v2 = -1;
+    free(P.eta);
+    free(P.nextEta);
+    free(P.phiEta);
+    free(P.found);
+    free(P.sign);
+    free(P.liveOffsets);
+    free(P.liveTargets);
 
     return F;
 }
 
 
 /**
- * @brief determines the player with a winning positional strategy in the parity game for the nodes in X
+ * @brief determines the player with a winning positional strategy in the parity game for the nodes of the subgame
  * 
- * @param X subset of nodes of G
- * @param G the graph with all the parity game information; G[x][0] - owner of node x; G[x][1] - priority of x; G[x][k] > -1, k > 1, (x, G[x][k]) is an edge 
- * @param n number of nodes of the graph
- * @return long** the subgraph with the nodes of X, also stores the winners of each node
+ * @param S the subgame, its winners are filled in
  */
-long **pgSubgraphSolver(long *X, long **G, long n) {
-    long xn = 0; //number of nodes in X
-    long x, i, j, l;
-    long v, w;
-    int M = -1; //maximum priority of the nodes in X
-
-    while(X[xn] >= 0) {
-        if(G[X[xn]][1] > M) {
-            M = G[X[xn]][1];
-        }
-        xn++;
-    }
+void pgSubgraphSolver(subgame *S) {
+    const game *G = S->G;
+    long v = S->vertices[0];
+    int M = -1; //maximum priority of the nodes in S
 
-    long **C = (long **) malloc(xn * sizeof(long *)); //the subgraph with the nodes of X, also stores the winners of each node
-    if(xn == 1) {
+    if(S->xn == 1) {
         //only one node, player that owns it loses at this position
-        C[0] = (long *) malloc (3 * sizeof(long));
-        i=2;
-        while(G[X[0]][i] != -2 && G[X[0]][i] != X[0]) {
-            i++;
-        }
-        if(G[X[0]][i] != -2) {
-            C[0][0] = 2 - (G[X[0]][1] % 2); //this subgraph consists of a node with an edge to itself
-        } else if(G[X[0]][0] == 2) {
-            C[0][0] = 1; //this node is a sink, player that owns it loses at this position
-        } else C[0][0] = 2;
-        C[0][1] = X[0];
-        C[0][2] = -2;
-        return C;
+        if(S->offsets[1] > 0) {
+            S->winner[0] = 2 - (G->priority[v] % 2); //this subgraph consists of a node with an edge to itself
+        } else if(G->owner[v] == 2) {
+            S->winner[0] = 1; //this node is a sink, player that owns it loses at this position
+        } else S->winner[0] = 2;
+        return;
     }
 
-
-    for(x = 0; x < xn; x++) {
-        v = X[x];
-        C[x] = (long *) malloc((xn+3) * sizeof(long));
-        C[x][0] = 0; //no winner determined yet
-        C[x][1] = v; //the vertex of G which x corresponds to
-        //add all outgoing edges of v which lead to another node in X
-        l=2;
-        for(i = 2; G[v][i] > -2; i++) {
-            if(G[v][i] > -1) {
-                for(j = 0; j < xn; j++) {
-                    if(X[j] == G[v][i]) {
-                        C[x][l] = j;
-                        l++;
-                    }
-                }
-            }
+    for(long x = 0; x < S->xn; x++) {
+        if((int) G->priority[S->vertices[x]] > M) {
+            M = G->priority[S->vertices[x]];
         }
-        C[x][l] = -2;
     }
 
-    pgStrategyImprovement(C, xn, M, G);
-
-    return C;
+    pgStrategyImprovement(S, M);
 }
 
 
 /**
  * @brief Solves the parity game through 
  * 
- * @param G the graph with all the parity game information; G[x][0] - owner of node x; G[x][1] - priority of x; G[x][k] > -1, k > 1, (x, G[x][k]) is an edge 
- * @param n number of nodes in the graph
+ * @param input the game, it is not changed
  * @return int* W[x] - the player that has a winning positional strategy at node x
  */
-int *pgSolver2(long **G, long n) {
+int *pgSolver2(const game *input) {
+    game *G = shareGame(input); //the obsolete edges are removed from G
+    long n = G->n;
     long r; //number of subsets left to solve
     long *newXr; //a subset that is obtained from removing all vertices with known winners from X[r]
     long xn; //number of vertices in a subset
     int *W = (int *) malloc (n * sizeof(int)); //W[x] - the player that has a winning positional strategy at node x
     long **X = (long **) malloc ((n+1) * sizeof(long *)); //Array of subsets
-    edge *F; //array of n-obsolete edges
-    long **C; //The graph formed from the subset X[r], also contains the winners of each node
-
-    F = pgObsolete(n, G, n); //find all n-obsolete edges
-    while(F[0].v1 != -1) { 
-        //After removing all n-obsolete edges in the graph, more n-obsolete edges may be discovered
-        //We keep removing n-obsolete edges until no more are found
-        long k = 0;
-        long i;
-        long j;
-        while (F[k].v1 != -1) {
-            i = F[k].v1;
-            j = 2;
-            while(G[i][j] != F[k].v2) {
-                j++;
+    edge *F; //array of k-obsolete edges
+    long k; //the maximum length of the cycles of the obsolete edges
+    long *sources; //the vertices that are examined in the next search for obsolete edges, all if NULL
+    subgame S; //the subgame formed from the subset X[r], also contains the winners of each node
+    attractor *A; //the attractor state of both players, kept for the whole loop
+    long *local; //scratch array for addSubsets, local[v] = -1 outside of it
+    sccShared *P = NULL; //the state of the parallel split into strongly connected components, kept for the whole loop
+
+    //After removing all k-obsolete edges in the graph, more k-obsolete edges may be discovered
+    //We keep removing k-obsolete edges until no more are found, then try longer cycles until k = n
+    //Only the sources that can reach a removed edge can have new obsolete edges, the others are not examined again
+    k = (options.adaptiveK > 0 && options.adaptiveK < n) ? options.adaptiveK : n;
+    sources = NULL; //all vertices
+    while(1) {
+        F = pgObsolete(k, G, sources); //find all k-obsolete edges
+        free(sources);
+        if(F[0].v1 == (unsigned long) -1) {
+            free(F);
+            if(k >= n) {
+                break;
             }
-            G[i][j] = -1; //Remove the n-obsolete edge
-            k++;
+            k = (2 * k < n) ? 2 * k : n;
+            sources = NULL;
+            continue;
         }
+        sources = reachingVertices(G, F);
+        removeEdges(G, F); //Remove the k-obsolete edges
         free(F);
-        F = pgObsolete(n, G, n);
     }
-    free(F);
 
     //initialize the W array
     for(long i=0; i<n; i++) {
         W[i] = 0; 
     }
+    A = newAttractor(G);
+    if(options.parallelScc && options.threads > 1) {
+        P = newSccState(G, A->predOffsets, A->predSources);
+    }
+    local = (long *) malloc((n+1) * sizeof(long));
+    verify_alloc(local);
+    for(long i=0; i<n; i++) {
+        local[i] = -1;
+    }
 
     if(n == 0) {
         r = 0;
@@ -287,22 +299,31 @@ int *pgSolver2(long **G, long n) {
         newXr[xn] = -2;
         X[r] = newXr;
 
-        r = addSubsets(X, r, G, n); //add all the strongly connected components of X[r] to X
+        r = addSubsets(X, r, G, local, P); //add all the strongly connected components of X[r] to X
 
-        C = pgSubgraphSolver(X[r], G, n); //solve the mpg of subgraph X[r]
-        for(long i=0; X[r][i] > -2; i++) {
-            W[C[i][1]] = C[i][0]; //store the winners of the nodes in X[r]
-            free(C[i]);
+        copySubgame(&S, X[r], G, local);
+        pgSubgraphSolver(&S); //solve the parity game of subgraph X[r]
+        for(long i=0; i < S.xn; i++) {
+            if(S.winner[i] != 0) {
+                setWinner(A, W, S.vertices[i], S.winner[i]); //store the winners of the nodes in X[r]
+            }
         }
-        free(C);
+        freeSubgame(&S);
         free(X[r]);
         r--;
 
-        reach(W, 1, G, n); //play the reachability game for P1
-        reach(W, 2, G, n); //play the reachability game for P2
+        //play the reachability games, starting from the positions that were just decided
+        attract(A, W, 1); //play the reachability game for P1
+        attract(A, W, 2); //play the reachability game for P2
     }
     
     free(X);
+    if(P != NULL) {
+        freeSccState(P);
+    }
+    freeAttractor(A);
+    free(local);
+    freeGame(G);
 
     return W;
 }
\ No newline at end of file
@@ -1,7 +1,48 @@
 #ifndef PGSOLVER2_H_INCLUDED
 #define PGSOLVER2_H_INCLUDED
 
-int *pgSolver2(long **G, long n);
-long **pgSubgraphSolver(long *X, long **G, long n);
+#include "graphFunctions.h"
+
+/**
+ * @brief the state of a search for k-obsolete edges, shared by the threads of pgObsolete
+ */
+typedef struct pgObsoleteSearch {
+    long k; //the maximum length of the cycle
+    game *G; //the game
+    long *sources; //the source vertices that are examined, all vertices if NULL
+    int8_t *sign; //sign[w] - epsilon(w)
+    uint32_t *liveOffsets; //the edges of G that have not been removed, see liveEdges
+    uint32_t *liveTargets;
+    long **eta; //eta[t], nextEta[t] - the two value arrays of thread t
+    long **nextEta;
+    long long **phiEta; //phiEta[t] - phi of the values in eta[t], in the type of largestTarget
+    edgeList *found; //found[t] - the obsolete edges found by thread t
+} pgObsoleteSearch;
+
+/**
+ * @brief phi for a source vertex with epsilon ev: the value n, made negative if it is advantageous for P1
+ *
+ * @param n an integer value
+ * @param ev epsilon of the source vertex, used when n is infinite
+ * @param inf a stand-in for infinity
+ * @return long n or -n
+ */
+static inline long phiSigned(long n, int ev, long inf) {
+    if(n == inf || n == -inf) {
+        return ev * n;
+    }
+
+    if(n % 2 == 1) {
+        return -n;
+    } 
+
+    return n;
+}
+
+int *pgSolver2(const game *G);
+void pgSubgraphSolver(subgame *S);
+int phi(int n, int t, int inf, game *G);
+void pgObsoleteSource(long x, int thread, void *arg);
+edge* pgObsolete(long k, game *G, long *sources);
 
 #endif
@@ -1,317 +1,1027 @@
 #include "utilities.h"
 #include "strategyImprovement.h"
 
+improvementStats improvementCounters = {{0, 0, 0}, 0, 0, 0};
+
 /**
- * @brief Caluclate Val[v]
- * 
- * @param Val the valuations of each vertex
- * @param finished finished[v] = 0 if Val[v] has not yet been calculated for the current strategies
- * @param v the vertex for which we are calculating Val[v]
- * @param sigma the strategy of P2
- * @param tau the strategy of P1
- * @param C the subgraph of G with the nodes from X; C[x][0] - winner at x; C[x][1] - corresponding node in G
- * @param xn the number of nodes in X
- * @param G the graph with all the parity game information; G[x][0] - owner of node x; G[x][1] - priority of x; G[x][k] > -1, k > 1, (x, G[x][k]) is an edge
- * @param M the maximum priority in G
+ * @brief allocates the valuations of a subgame with xn vertices and sets the valuation of the empty play
+ *
+ * @param V the valuations
+ * @param xn number of vertices in the subgame
+ * @param M the maximum priority in the subgame
  */
-void evaluate(valuation *Val, int *finished, long v, long *sigma, long *tau, long **C, long xn, long **G, int M) {
-    if(finished[v] == 1) {
-        return; //Val[v] has already been computed
+void newValuations(valuations *V, long xn, int M) {
+    size_t rows = xn + 1; //the vertices and the empty play
+    size_t keyBytes, countBytes;
+    char *arena;
+
+    V->M = M;
+    V->width = 1;
+    while(V->width < 32 && ((long) 1 << V->width) - 1 <= xn) {
+        V->width++; //a count is at most xn, so 2^width - 1 - count never borrows
     }
+    V->packed = (M + 1) * V->width <= (int) (8 * sizeof(valuationKey));
+
+    keyBytes = V->packed ? rows * sizeof(valuationKey) : 0;
+    countBytes = V->packed ? 0 : rows * (M + 1) * sizeof(uint32_t);
+    arena = (char *) malloc(keyBytes + countBytes + rows * sizeof(int32_t) + rows * sizeof(uint8_t));
+    verify_alloc(arena);
+    V->arena = arena;
+    V->key = V->packed ? (valuationKey *) arena : NULL;
+    V->L = V->packed ? NULL : (uint32_t *) (arena + keyBytes);
+    V->top = (int32_t *) (arena + keyBytes + countBytes);
+    V->infinite = (uint8_t *) (arena + keyBytes + countBytes + rows * sizeof(int32_t));
+
+    //the empty play: every count is 0
+    V->infinite[xn] = 0;
+    V->top[xn] = -1;
+    if(V->packed) {
+        valuationKey field = ((valuationKey) 1 << V->width) - 1;
+        V->key[xn] = 0;
+        for(int p = 1; p <= M; p += 2) {
+            V->key[xn] |= field << (p * V->width);
+        }
+    }
+    else memset(V->L + xn * (M + 1), 0, (M + 1) * sizeof(uint32_t));
+}
 
-    int owner = G[C[v][1]][0]; //player that owns the vertex C[v][1]
-    int omega = G[C[v][1]][1]; //priority of vertex C[v][1]
-    int w; //the next vertex according to the 2 strategies
-
-    long i;
+/**
+ * @brief frees the valuations
+ *
+ * @param V the valuations
+ */
+void freeValuations(valuations *V) {
+    free(V->arena);
+    V->arena = NULL;
+}
 
-    //initialize Val[v]
-    Val[v].infinite = 0;
-    for(i=0; i<=M; i++) {
-        Val[v].L[i] = 0;
-    }
-    finished[v] = 0; //this means we have begun looking into the play that starts at v
-    //we do not yet know if the play is finite or not
-                    
-    if(owner == 2 && sigma[v] == -1) {
-        //This is a finite play
-        Val[v].L[omega]++;
-        finished[v] = 1; //we have finished calculating Val[v]
-        return;
+/**
+ * @brief Caluclate the valuation of v and of every vertex on the play that starts at v
+ *
+ * The two strategies make every vertex point to the next vertex of the play, or to the empty play, so the plays form a
+ * functional graph. The play is followed until it reaches a vertex with a known valuation, the empty play or a vertex
+ * that is already on it. In the last case the vertices from that one on form a cycle: its maximum priority is found
+ * once and decides the valuation of all of them. Then the valuations are filled in backwards along the play, each one
+ * from the next vertex. This takes O(M) per vertex, or O(1) with packed valuations, and needs no recursion.
+ * 
+ * @param V the valuations of each vertex
+ * @param finished finished[v] = 1 if the valuation of v has been calculated for the current strategies, -1 if not;
+ * it is 0 while v is on the play that is being followed
+ * @param v the vertex for which we are calculating its valuation
+ * @param sigma the strategy of P2
+ * @param tau the strategy of P1
+ * @param S the subgame that is solved
+ * @param path scratch array of S->xn entries, holds the play that is being followed
+ */
+void evaluate(valuations *V, int *finished, long v, long *sigma, long *tau, subgame *S, long *path) {
+    const game *G = S->G;
+    long xn = S->xn;
+    int M = V->M;
+    long length = 0; //number of vertices on path
+    long w; //the next vertex according to the 2 strategies, xn for the empty play
+    long u;
+    int omega;
+
+    //follow the play until its valuation is known
+    w = v;
+    while(w < xn && finished[w] == -1) {
+        finished[w] = 0; //this means we have begun looking into the play that starts at w
+        path[length++] = w;
+        if(G->owner[S->vertices[w]] == 1) {
+            w = tau[w];
+        }
+        else w = sigma[w];
+        if(w == -1) {
+            w = xn; //This is a finite play, the last vertex on path is its last vertex
+        }
     }
 
-    //Determine the next vertex in the play
-    if(owner == 1) {
-        w = tau[v];
-    }
-    else w = sigma[v];
-    
-    if(finished[w] == 0) {
-        //There is a cycle
-        //We know that because the value of Val[w] depends on the value of Val[v]
-        //However, w is also the next vertex in the play after v
-        //So there is a cycle that contains both v and w
-        int max = omega;
-        int wOwner;
-        int wOmega;
+    if(w < xn && finished[w] == 0) {
+        //There is a cycle from w to the end of path
+        int max = -1;
+        long start = length;
 
         //Determine the maximum priority in the cycle
-        while(w != v) {
-            wOwner = G[C[w][1]][0];
-            wOmega = G[C[w][1]][1];
-            
-            if(wOmega > max) {
-                max = wOmega;
+        do {
+            start--;
+            omega = G->priority[S->vertices[path[start]]];
+            if(omega > max) {
+                max = omega;
             }
+        } while(path[start] != w);
 
-            if(wOwner == 1) {
-                w= tau[w];
-            } else w = sigma[w];
+        for(long j = start; j < length; j++) {
+            V->infinite[path[j]] = (max % 2 == 1) ? 1 : 2;
+            finished[path[j]] = 1; //we have finished calculating V[path[j]]
         }
+        length = start;
+        w = path[start];
+    }
 
-        if(max % 2 == 1) {
-            Val[v].infinite = 1;
+    //every vertex left on path comes before w in the play
+    while(length > 0) {
+        u = path[--length];
+        omega = G->priority[S->vertices[u]];
+        V->infinite[u] = V->infinite[w];
+        if(V->infinite[w] == 0) {
+            //The play is finite: the play from w with this occurance of the value omega
+            V->top[u] = (V->top[w] > omega) ? V->top[w] : omega;
+            if(V->packed) {
+                valuationKey unit = (valuationKey) 1 << (omega * V->width);
+                V->key[u] = (omega % 2 == 0) ? V->key[w] + unit : V->key[w] - unit;
+            }
+            else {
+                memcpy(V->L + u * (M + 1), V->L + w * (M + 1), (M + 1) * sizeof(uint32_t));
+                V->L[u * (M + 1) + omega]++;
+            }
         }
-        else Val[v].infinite = 2;
+        //otherwise we are in a cycle, the maximum priority in the cycle has already been calculated
+        finished[u] = 1; //we have finished calculating V[u]
+        w = u;
+    }
+}
 
-        finished[v] = 1; //we have finished calculating Val[v]
+/**
+ * @brief evaluates the vertices of group g. Called by evaluateVertices for every group, on any thread
+ *
+ * @param g the number of the group
+ * @param thread the number of the thread
+ * @param arg the evaluationGroups
+ */
+void evaluateGroup(long g, int thread, void *arg) {
+    evaluationGroups *E = (evaluationGroups *) arg;
 
-        return;
+    for(long j = E->groupStart[g]; j < E->groupStart[g+1]; j++) {
+        evaluate(E->V, E->finished, E->order[j], E->sigma, E->tau, E->S, E->path[thread]);
     }
+}
 
-    if(finished[w] == -1) {
-        //we need to know Val[w] to determine Val[v]
-        //however, Val[w] has not yet been determined
-        evaluate(Val, finished, w, sigma, tau, C, xn, G, M);
+/**
+ * @brief returns the root of the tree of x in the union-find forest, and shortens the path to it
+ */
+static long findGroup(long *parent, long x) {
+    while(parent[x] != x) {
+        parent[x] = parent[parent[x]];
+        x = parent[x];
     }
+    return x;
+}
 
-    if(Val[w].infinite == 0) {
-        //The play is finite
-        for(i=0; i<=M; i++) {
-            Val[v].L[i] = Val[w].L[i];
+/**
+ * @brief evaluates the given vertices, whose finished value is -1. On subgames with at least
+ * options.improvementThreshold vertices, the vertices are split into groups: a vertex and the next vertex of its play are
+ * in the same group if both have to be evaluated. A play only passes through vertices of its own group or vertices with
+ * a known valuation, so the groups are evaluated in parallel, one group per step of parallelFor
+ *
+ * @param E the scratch arrays and the state of the solve
+ * @param vertices the vertices to evaluate
+ * @param count number of vertices
+ */
+void evaluateVertices(evaluationGroups *E, long *vertices, long count) {
+    subgame *S = E->S;
+    long groups = 0;
+    long v, w, r;
+
+    if(options.threads <= 1 || S->xn < options.improvementThreshold) {
+        for(long j = 0; j < count; j++) {
+            evaluate(E->V, E->finished, vertices[j], E->sigma, E->tau, S, E->path[0]);
         }
-        Val[v].L[omega]++; //Add this occurance of the value omega
+        return;
     }
-    else {
-        //We are in a cycle
-        //The maximum priority in the cycle has already been calculated
-        Val[v].infinite = Val[w].infinite;
+
+    for(long j = 0; j < count; j++) {
+        E->parent[vertices[j]] = vertices[j];
+    }
+    for(long j = 0; j < count; j++) {
+        v = vertices[j];
+        w = (S->G->owner[S->vertices[v]] == 1) ? E->tau[v] : E->sigma[v];
+        if(w != -1 && E->finished[w] == -1) {
+            E->parent[findGroup(E->parent, v)] = findGroup(E->parent, w);
+        }
     }
 
-    finished[v] = 1; //we have finished calculating Val[v]
+    //number the groups and sort the vertices by group
+    for(long j = 0; j < count; j++) {
+        v = vertices[j];
+        if(findGroup(E->parent, v) == v) {
+            E->index[v] = groups;
+            E->groupStart[++groups] = 0;
+        }
+    }
+    E->groupStart[0] = 0;
+    for(long j = 0; j < count; j++) {
+        r = findGroup(E->parent, vertices[j]);
+        E->groupStart[E->index[r] + 1]++;
+    }
+    for(long g = 0; g < groups; g++) {
+        E->groupStart[g+1] += E->groupStart[g];
+    }
+    for(long j = 0; j < count; j++) {
+        r = E->index[findGroup(E->parent, vertices[j])];
+        E->order[E->groupStart[r]++] = vertices[j];
+    }
+    for(long g = groups; g > 0; g--) {
+        E->groupStart[g] = E->groupStart[g-1];
+    }
+    E->groupStart[0] = 0;
 
+    parallelFor(groups, evaluateGroup, E);
 }
 
 /**
  * @brief Returns 1 if (v, y) is preferrable to (v, x) for P2, 0 if it is the same, -1 if prefferable for P1
  * 
- * @param Val the current valuation
- * @param x a node
- * @param y a node
- * @param M maximum value in the graph
+ * @param V the current valuation
+ * @param x a node, -1 for ending the game
+ * @param y a node, -1 for ending the game
+ * @param xn number of vertices in the subgame
  * @return int 1 if (v, y) is preferrable to (v, x) for P2, 0 if it is the same, -1 if prefferable for P1
  */
-int isSwitchable(valuation *Val, long x, long y, int M) {
+int isSwitchable(valuations *V, long x, long y, long xn) {
     int p;
 
     if(x == y) {
         return 0;
     }
-
     if(x == -1) {
-        if(Val[y].infinite == 1) {
-            return -1;
-        }
+        x = xn; //the empty play
+    }
+    if(y == -1) {
+        y = xn;
+    }
 
-        if(Val[y].infinite == 2) {
+    if(V->infinite[x] != 0 || V->infinite[y] != 0) {
+        if(V->infinite[x] == V->infinite[y]) {
+            return 0;
+        }
+        //a cycle won by P2 is the best play for P2, then the finite plays, then a cycle won by P1
+        if(V->infinite[y] == 2 || V->infinite[x] == 1) {
             return 1;
         }
+        return -1;
+    }
 
-        p = -1;
-        for(int i=M; i >= 0; i--) {
-            if(Val[y].L[i] > 0) {
-                p = i;
-                break;
-            }
-        }
+    //neither x nor y are infinite plays
 
-        if(p==-1) {
+    if(V->packed) {
+        if(V->key[x] == V->key[y]) {
             return 0;
         }
+        return (V->key[y] > V->key[x]) ? 1 : -1;
+    }
 
-        if(p % 2 == 0) {
-            return 1;
+    //the largest priority at which the counts differ
+    const uint32_t *Lx = V->L + x * (V->M + 1);
+    const uint32_t *Ly = V->L + y * (V->M + 1);
+    if(V->top[x] != V->top[y]) {
+        p = (V->top[x] > V->top[y]) ? V->top[x] : V->top[y];
+    }
+    else {
+        p = V->top[x];
+        while(p >= 0 && Lx[p] == Ly[p]) {
+            p--;
         }
+    }
 
-        return -1;
+    if(p < 0) {
+        return 0;
     }
 
-    if(y == -1) {
-        if(Val[x].infinite == 1) {
+    if(p % 2 == 0) {
+        if(Lx[p] < Ly[p]) {
             return 1;
         }
+        return -1; //Lx[p] > Ly[p]
+    }
+
+    //p % 2 == 1
+    if(Lx[p] > Ly[p]) {
+        return 1;
+    }
+    return -1;
+}
+
+
+/**
+ * @brief returns 1 if moving from u to w is an improvement for the player
+ *
+ * @param V the current valuation
+ * @param player the player number
+ * @param u the current next vertex, -1 for ending the game
+ * @param w the new next vertex, -1 for ending the game
+ * @param xn number of vertices in the subgame
+ * @return int 1 if w is strictly better than u for the player
+ */
+static inline int improves(valuations *V, int player, long u, long w, long xn) {
+    return isSwitchable(V, u, w, xn) == ((player == 2) ? 1 : -1);
+}
+
+/**
+ * @brief sets the next vertex of v in the strategy of its owner
+ */
+static inline void setStrategy(int owner, long v, long w, long *sigma, long *tau) {
+    if(owner == 2) {
+        sigma[v] = w;
+    }
+    else tau[v] = w;
+}
+
+/**
+ * @brief runs body for the steps 0 to count - 1, on all threads if the subgame has at least
+ * options.improvementThreshold vertices
+ *
+ * @param count number of steps
+ * @param body the function called for every step
+ * @param arg passed to body
+ * @param xn number of vertices in the subgame
+ */
+static void improvementFor(long count, loopBody body, void *arg, long xn) {
+    if(options.threads > 1 && xn >= options.improvementThreshold) {
+        parallelFor(count, body, arg);
+        return;
+    }
+    for(long i = 0; i < count; i++) {
+        body(i, 0, arg);
+    }
+}
+
+/**
+ * @brief finds the new strategy of the examined vertices from chunk * SWITCH_CHUNK to (chunk + 1) * SWITCH_CHUNK - 1,
+ * without changing the strategies. Called by switchEdges and bestResponse for every chunk, on any thread
+ *
+ * @param chunk the number of the chunk
+ * @param thread the number of the thread, not needed since the threads only write to their own part of Q->choice
+ * @param arg the switchSearch
+ */
+void findSwitches(long chunk, int thread, void *arg) {
+    switchSearch *Q = (switchSearch *) arg;
+    (void) thread;
+    subgame *S = Q->S;
+    const game *G = S->G;
+    long end = ((chunk + 1) * SWITCH_CHUNK < Q->count) ? (chunk + 1) * SWITCH_CHUNK : Q->count;
+    long v, u, w;
+    uint32_t i, c, choices;
+    int owner;
+
+    for(long j = chunk * SWITCH_CHUNK; j < end; j++) {
+        v = (Q->vertices != NULL) ? Q->vertices[j] : j;
+        owner = G->owner[S->vertices[v]];
+        Q->choice[j] = -2;
+        if(owner != Q->player) {
+            continue;
+        }
+        u = (owner == 2) ? Q->sigma[v] : Q->tau[v];
+
+        //choice i < S->offsets[v+1] is the edge i, choice S->offsets[v+1] is ending the game, which only P2 can do
+        choices = S->offsets[v+1] - S->offsets[v] + ((owner == 2) ? 1 : 0);
+        for(c = 0; c < choices; c++) {
+            i = S->offsets[v] + c;
+            w = (i < S->offsets[v+1]) ? (long) S->targets[i] : -1;
+            if(Q->allowed != NULL && !Q->allowed[i + v]) {
+                continue;
+            }
+            if(improves(Q->V, owner, u, w, S->xn)) {
+                //V[u] |= V[w] (choosing w is better for the player)
+                Q->choice[j] = w;
+                u = w;
+                if(Q->first) {
+                    break;
+                }
+            }
+        }
+    }
+}
 
-        if(Val[x].infinite == 2) {
-            return -1;
+/**
+ * @brief finds the switch of a single switch policy among the vertices from chunk * SWITCH_CHUNK to
+ * (chunk + 1) * SWITCH_CHUNK - 1 and stores it in Q->P->chunkVertex[chunk] and Q->P->chunkChoice[chunk]. With
+ * SWITCH_RANDOM_EDGE, the improving choices are counted in Q->P->chunkCandidates[chunk] and only the one with number
+ * pick is stored, none if pick is -1
+ *
+ * @param Q the search
+ * @param chunk the number of the chunk
+ * @param pick SWITCH_RANDOM_EDGE: the number of the improving choice to store
+ */
+static void scanChunk(switchSearch *Q, long chunk, long pick) {
+    subgame *S = Q->S;
+    const game *G = S->G;
+    switchPolicy *P = Q->P;
+    long xn = S->xn;
+    long end = ((chunk + 1) * SWITCH_CHUNK < xn) ? (chunk + 1) * SWITCH_CHUNK : xn;
+    long v, u, w;
+    long chosenV = -1, chosenW = -1, chosenChoice = -1; //the switch found so far
+    long candidates = 0; //number of improving choices seen by SWITCH_RANDOM_EDGE
+    uint32_t i, c, choices;
+
+    for(v = chunk * SWITCH_CHUNK; v < end; v++) {
+        if(G->owner[S->vertices[v]] != Q->player) {
+            continue;
         }
+        u = (Q->player == 2) ? Q->sigma[v] : Q->tau[v];
+
+        //choice i < S->offsets[v+1] is the edge i, choice S->offsets[v+1] is ending the game, which only P2 can do
+        choices = S->offsets[v+1] - S->offsets[v] + ((Q->player == 2) ? 1 : 0);
+        for(c = 0; c < choices; c++) {
+            i = S->offsets[v] + c;
+            w = (i < S->offsets[v+1]) ? (long) S->targets[i] : -1;
+            if(!improves(Q->V, Q->player, u, w, xn)) {
+                continue;
+            }
 
-        p = -1;
-        for(int i=M; i >= 0; i--) {
-            if(Val[x].L[i] > 0) {
-                p = i;
-                break;
+            if(P->policy == SWITCH_SINGLE_BEST) {
+                if(chosenV == -1 || improves(Q->V, Q->player, chosenW, w, xn)) {
+                    chosenV = v;
+                    chosenW = w;
+                    chosenChoice = i + v;
+                }
+            }
+            else if(P->policy == SWITCH_RANDOM_EDGE) {
+                if(candidates++ == pick) {
+                    chosenV = v;
+                    chosenChoice = i + v;
+                }
+            }
+            else if(chosenV == -1 || P->rank[i + v] < P->rank[chosenChoice]) {
+                chosenV = v;
+                chosenChoice = i + v;
             }
         }
+    }
 
-        if(p == -1) {
-            return 0;
+    P->chunkVertex[chunk] = chosenV;
+    P->chunkChoice[chunk] = chosenChoice;
+    P->chunkCandidates[chunk] = candidates;
+}
+
+/**
+ * @brief finds the switch of a single switch policy in one chunk of vertices, see scanChunk. Called by switchEdges for
+ * every chunk, on any thread
+ *
+ * @param chunk the number of the chunk
+ * @param thread the number of the thread, not needed since every chunk has its own entries in the arrays of Q->P
+ * @param arg the switchSearch
+ */
+void findSingleSwitch(long chunk, int thread, void *arg) {
+    (void) thread;
+    scanChunk((switchSearch *) arg, chunk, -1);
+}
+
+/**
+ * @brief improve the strategy of the given player with the switching policy of P
+ *
+ * The choices of a vertex of the player are its edges, in order, and for P2 ending the game (-1) after them. With
+ * SWITCH_ALL_BEST every vertex that has a better choice than its current one switches to the best of them, with
+ * SWITCH_ALL_FIRST to the first one; the vertices are examined in parallel by findSwitches and the switches are made in
+ * the order of the vertices. The single switch policies switch one vertex: to the best valuation among all
+ * improving choices (SWITCH_SINGLE_BEST), to an improving choice picked uniformly at random (SWITCH_RANDOM_EDGE), or to
+ * the improving choice that comes first in the random order P->rank fixed at the start of the solve
+ * (SWITCH_RANDOM_ORDER). Every chunk of vertices finds its own switch in parallel with findSingleSwitch, and the switches
+ * of the chunks are compared in chunk order, so the result does not depend on the number of threads. SWITCH_RANDOM_EDGE
+ * counts the improving choices of every chunk instead, draws one number and looks it up again in its chunk.
+ * SWITCH_RESTRICTED_BEST is handled by restrictedImprovement and SWITCH_RANDOM_FACET by randomFacet.
+ * 
+ * @param S the subgame that is solved
+ * @param player the player number
+ * @param V the valuation at the start of the function
+ * @param sigma the strategy of P2
+ * @param tau the strategy of P1
+ * @param P the switching policy and its state
+ * @param switched the vertices whose strategy was changed are stored here, at most S->xn
+ * @return long the number of vertices whose strategy was changed, 0 if there was no switch made
+ */
+long switchEdges(subgame *S, int player, valuations *V, long *sigma, long *tau, switchPolicy *P, long *switched) {
+    long xn = S->xn;
+    long chunks = (xn + SWITCH_CHUNK - 1) / SWITCH_CHUNK;
+    long v, w, c;
+    uint32_t i;
+    long switchCount = 0; //number of vertices with a switch
+    long chosenV = -1, chosenW = -1; //the switch of the single switch policies
+    long candidates = 0; //number of improving choices of SWITCH_RANDOM_EDGE
+    uint32_t chosenRank = UINT32_MAX; //the rank of the switch of SWITCH_RANDOM_ORDER
+
+    if(P->policy == SWITCH_ALL_BEST || P->policy == SWITCH_ALL_FIRST) {
+        switchSearch Q = {S, V, player, P->policy == SWITCH_ALL_FIRST, sigma, tau, NULL, xn, P->choice, NULL, NULL};
+        improvementFor(chunks, findSwitches, &Q, xn);
+        for(v = 0; v < xn; v++) {
+            if(P->choice[v] != -2) {
+                //every switch is to a strictly better choice, so the strategy of v has changed
+                setStrategy(player, v, P->choice[v], sigma, tau);
+                switched[switchCount++] = v;
+            }
         }
+        improvementCounters.rounds[player]++;
+        improvementCounters.switches += switchCount;
+
+        return switchCount;
+    }
 
-        if(p % 2 == 0) {
-            return -1;
+    //the single switch policies find a switch in every chunk, then pick one of them in chunk order
+    switchSearch Q = {S, V, player, 0, sigma, tau, NULL, xn, P->choice, NULL, P};
+    improvementFor(chunks, findSingleSwitch, &Q, xn);
+    for(c = 0; c < chunks; c++) {
+        if(P->policy == SWITCH_RANDOM_EDGE) {
+            candidates += P->chunkCandidates[c];
+            continue;
+        }
+        if(P->chunkVertex[c] == -1) {
+            continue;
+        }
+        v = P->chunkVertex[c];
+        i = P->chunkChoice[c] - v;
+        w = (i < S->offsets[v+1]) ? (long) S->targets[i] : -1;
+        if(chosenV == -1 || (P->policy == SWITCH_SINGLE_BEST && improves(V, player, chosenW, w, xn))
+           || (P->policy == SWITCH_RANDOM_ORDER && P->rank[P->chunkChoice[c]] < chosenRank)) {
+            chosenV = v;
+            chosenW = w;
+            chosenRank = (P->policy == SWITCH_RANDOM_ORDER) ? P->rank[P->chunkChoice[c]] : UINT32_MAX;
         }
-        return 1;
+    }
+    if(candidates > 0) {
+        //every improving choice is picked with the same probability
+        long pick = rand_r(&P->seed) % candidates;
+        for(c = 0; pick >= P->chunkCandidates[c]; c++) {
+            pick -= P->chunkCandidates[c];
+        }
+        scanChunk(&Q, c, pick);
+        chosenV = P->chunkVertex[c];
+        i = P->chunkChoice[c] - chosenV;
+        chosenW = (i < S->offsets[chosenV+1]) ? (long) S->targets[i] : -1;
     }
 
-    if(Val[x].infinite != 0 && Val[y].infinite != 0) {
-        if(Val[x].infinite == Val[y].infinite) {
-            return 0;
+    if(chosenV != -1) {
+        setStrategy(player, chosenV, chosenW, sigma, tau);
+        switched[switchCount++] = chosenV;
+    }
+
+    improvementCounters.rounds[player]++;
+    improvementCounters.switches += switchCount;
+    
+    return switchCount;
+}
+
+/**
+ * @brief creates the reverse of the graph of the two strategies: the children of w are the vertices whose next vertex
+ * in the play is w, and the children of S->xn are the last vertices of finite plays
+ *
+ * @param F the forest
+ * @param S the subgame that is solved
+ * @param sigma the strategy of P2
+ * @param tau the strategy of P1
+ */
+void newStrategyForest(strategyForest *F, subgame *S, long *sigma, long *tau) {
+    long xn = S->xn;
+
+    F->xn = xn;
+    F->parent = (long *) malloc((xn + 1) * sizeof(long));
+    F->firstChild = (long *) malloc((xn + 1) * sizeof(long));
+    F->nextSibling = (long *) malloc((xn + 1) * sizeof(long));
+    F->prevSibling = (long *) malloc((xn + 1) * sizeof(long));
+    verify_alloc(F->parent);
+    verify_alloc(F->firstChild);
+    verify_alloc(F->nextSibling);
+    verify_alloc(F->prevSibling);
+
+    for(long v = 0; v <= xn; v++) {
+        F->firstChild[v] = -1;
+    }
+    for(long v = 0; v < xn; v++) {
+        F->parent[v] = -1;
+        moveVertex(F, v, (S->G->owner[S->vertices[v]] == 1) ? tau[v] : sigma[v]);
+    }
+}
+
+/**
+ * @brief frees the forest
+ *
+ * @param F the forest
+ */
+void freeStrategyForest(strategyForest *F) {
+    free(F->parent);
+    free(F->firstChild);
+    free(F->nextSibling);
+    free(F->prevSibling);
+}
+
+/**
+ * @brief makes w the next vertex of the play from v
+ *
+ * @param F the forest
+ * @param v a vertex
+ * @param w the new next vertex, -1 for the empty play
+ */
+void moveVertex(strategyForest *F, long v, long w) {
+    if(w == -1) {
+        w = F->xn;
+    }
+
+    //remove v from the children of its old parent
+    if(F->parent[v] != -1) {
+        if(F->prevSibling[v] != -1) {
+            F->nextSibling[F->prevSibling[v]] = F->nextSibling[v];
         }
-        if(Val[x].infinite == 2) {
-            return -1;
+        else F->firstChild[F->parent[v]] = F->nextSibling[v];
+        if(F->nextSibling[v] != -1) {
+            F->prevSibling[F->nextSibling[v]] = F->prevSibling[v];
         }
+    }
 
-        return 1; //Val[y].infinite == 2
+    F->parent[v] = w;
+    F->prevSibling[v] = -1;
+    F->nextSibling[v] = F->firstChild[w];
+    if(F->firstChild[w] != -1) {
+        F->prevSibling[F->firstChild[w]] = v;
     }
+    F->firstChild[w] = v;
+}
 
-    if(Val[x].infinite != Val[y].infinite) {
-        //one of them is a finite play, the other is not
-        if(Val[x].infinite == 0) {
-            if(Val[y].infinite == 1) {
-                return -1;
+/**
+ * @brief recomputes the valuations after the strategies of some vertices were changed. Only the vertices whose play
+ * passed through a changed vertex, which are the changed vertices and their descendants in the forest of the old
+ * strategies, can have a different valuation
+ *
+ * @param S the subgame that is solved
+ * @param F the forest of the old strategies, it is updated to the new ones
+ * @param switched the vertices whose strategy was changed
+ * @param count number of vertices in switched
+ * @param finished 1 for all vertices; the valuations that are recomputed, in E->V, are set to -1 and back to 1
+ * @param sigma the strategy of P2
+ * @param tau the strategy of P1
+ * @param queue the vertices that were reevaluated are stored here, at most S->xn
+ * @param E the scratch arrays of evaluateVertices
+ * @return long the number of vertices in queue
+ */
+long reevaluate(subgame *S, strategyForest *F, long *switched, long count, int *finished, long *sigma, long *tau,
+                long *queue, evaluationGroups *E) {
+    long qn = 0; //number of vertices in queue
+    long v, c;
+
+    //find the vertices whose play passes through a switched vertex with the old strategies
+    for(long j = 0; j < count; j++) {
+        if(finished[switched[j]] == 1) {
+            finished[switched[j]] = -1;
+            queue[qn++] = switched[j];
+        }
+    }
+    for(long j = 0; j < qn; j++) {
+        for(c = F->firstChild[queue[j]]; c != -1; c = F->nextSibling[c]) {
+            if(finished[c] == 1) {
+                finished[c] = -1;
+                queue[qn++] = c;
             }
-            return 1;
         }
+    }
+
+    for(long j = 0; j < count; j++) {
+        v = switched[j];
+        moveVertex(F, v, (S->G->owner[S->vertices[v]] == 1) ? tau[v] : sigma[v]);
+    }
 
-        if(Val[y].infinite == 0) {
-            if(Val[x].infinite == 1) {
-                return 1;
+    evaluateVertices(E, queue, qn);
+    improvementCounters.evaluations += qn;
+
+    return qn;
+}
+
+/**
+ * @brief replaces tau with the best response of P1 to sigma
+ *
+ * With sigma fixed, only P1 makes choices. Like the Bellman-Ford algorithm with a queue, only the vertices of P1 that
+ * have an edge to a vertex whose valuation changed are examined again: each round switches the examined vertices to
+ * their best edge, reevaluates the plays through them, and examines the P1 predecessors of the reevaluated vertices in
+ * the next round. At the end, no vertex of P1 has an improving edge, so tau is a best response.
+ *
+ * @param S the subgame that is solved
+ * @param V the valuations, correct for the current strategies
+ * @param F the forest of the current strategies
+ * @param sigma the strategy of P2
+ * @param tau the strategy of P1, it is improved
+ * @param finished 1 for all vertices
+ * @param predOffsets the reversed edges of P1 in the subgame: the vertices of P1 with an edge into w are
+ * predSources[predOffsets[w]], ..., predSources[predOffsets[w+1] - 1]
+ * @param predSources
+ * @param work scratch array of S->xn entries, the vertices examined in a round
+ * @param inWork scratch array of S->xn entries, all 0
+ * @param switched scratch array of S->xn entries
+ * @param queue scratch array of S->xn entries
+ * @param P the switching policy, its choice array is used to find the switches in parallel
+ * @param E the scratch arrays of evaluateVertices
+ * @return long the number of vertices whose strategy was changed
+ */
+long bestResponse(subgame *S, valuations *V, strategyForest *F, long *sigma, long *tau, int *finished,
+                  uint32_t *predOffsets, uint32_t *predSources, long *work, char *inWork, long *switched, long *queue,
+                  switchPolicy *P, evaluationGroups *E) {
+    const game *G = S->G;
+    long xn = S->xn;
+    long count = 0; //number of vertices in work
+    long switchCount, qn, total = 0;
+    long v, y;
+    uint32_t i;
+    switchSearch Q = {S, V, 1, 0, sigma, tau, work, 0, P->choice, NULL, NULL};
+
+    for(v = 0; v < xn; v++) {
+        if(G->owner[S->vertices[v]] == 1) {
+            work[count++] = v;
+            inWork[v] = 1;
+        }
+    }
+
+    while(count > 0) {
+        //find the best edge of every examined vertex in parallel, then switch them in order
+        switchCount = 0;
+        Q.count = count;
+        improvementFor((count + SWITCH_CHUNK - 1) / SWITCH_CHUNK, findSwitches, &Q, xn);
+        for(long j = 0; j < count; j++) {
+            v = work[j];
+            inWork[v] = 0;
+            if(P->choice[j] != -2) {
+                tau[v] = P->choice[j];
+                switched[switchCount++] = v;
+            }
+        }
+        improvementCounters.rounds[1]++;
+        improvementCounters.switches += switchCount;
+        total += switchCount;
+
+        qn = reevaluate(S, F, switched, switchCount, finished, sigma, tau, queue, E);
+
+        //only the vertices of P1 with an edge to a reevaluated vertex can have an improving edge now. If many vertices
+        //were reevaluated, going through all vertices in order is faster than following their predecessors
+        count = 0;
+        if(switchCount > 0 && qn > xn / 8) {
+            for(v = 0; v < xn; v++) {
+                if(G->owner[S->vertices[v]] == 1) {
+                    work[count++] = v;
+                }
+            }
+            continue;
+        }
+        for(long j = 0; j < qn; j++) {
+            for(i = predOffsets[queue[j]]; i < predOffsets[queue[j]+1]; i++) {
+                y = predSources[i];
+                if(!inWork[y]) {
+                    inWork[y] = 1;
+                    work[count++] = y;
+                }
             }
-            return -1;
         }
     }
 
-    //neither x nor y are -1, neither are infinite plays 
+    return total;
+}
 
-    p = -1;
-    for(int i=M; i>=0; i--) {
-        if(Val[x].L[i] != Val[y].L[i]) {
-            p=i;
-            break;
+/**
+ * @brief replaces sigma with the strategy that is best for P2 among all strategies that use, at every vertex of P2, its
+ * current choice or a choice that improves on it with the valuations at the start of the function
+ *
+ * The choices that may be used are marked in P->allowed. The best strategy of the game in which P2 only has those
+ * choices is then found by strategy improvement inside that game: every vertex of P2 switches to its best allowed
+ * choice, and P1 replies with its best response, until no allowed choice improves. This is not Schewe's optimal
+ * switching, which finds the same strategy in one step with a polynomial algorithm: here the number of inner rounds is
+ * not bounded, and each of them is counted in improvementCounters.innerRounds. The call itself is one round of P2.
+ *
+ * @param S the subgame that is solved
+ * @param V the valuations, correct for the current strategies
+ * @param F the forest of the current strategies
+ * @param sigma the strategy of P2, it is improved
+ * @param tau the strategy of P1, a best response to sigma; it is still one at the end
+ * @param finished 1 for all vertices
+ * @param predOffsets the reversed edges of P1 in the subgame, see bestResponse
+ * @param predSources
+ * @param work scratch array of S->xn entries
+ * @param inWork scratch array of S->xn entries, all 0
+ * @param switched scratch array of S->xn entries
+ * @param queue scratch array of S->xn entries
+ * @param P the switching policy, with P->allowed of S->offsets[S->xn] + S->xn entries
+ * @param E the scratch arrays of evaluateVertices
+ * @return long the number of switches of P2, 0 if sigma had no improving choice
+ */
+long restrictedImprovement(subgame *S, valuations *V, strategyForest *F, long *sigma, long *tau, int *finished,
+                           uint32_t *predOffsets, uint32_t *predSources, long *work, char *inWork, long *switched,
+                           long *queue, switchPolicy *P, evaluationGroups *E) {
+    const game *G = S->G;
+    long xn = S->xn;
+    long v, w, switchCount, total = 0;
+    uint32_t i;
+    switchSearch Q = {S, V, 2, 0, sigma, tau, NULL, xn, P->choice, P->allowed, NULL};
+
+    //the current and the improving choices of P2; choice S->offsets[v+1] of v is ending the game
+    for(v = 0; v < xn; v++) {
+        if(G->owner[S->vertices[v]] != 2) {
+            continue;
+        }
+        for(i = S->offsets[v]; i <= S->offsets[v+1]; i++) {
+            w = (i < S->offsets[v+1]) ? (long) S->targets[i] : -1;
+            P->allowed[i + v] = (w == sigma[v]) || improves(V, 2, sigma[v], w, xn);
         }
     }
 
-    if(p < 0) {
-        return 0;
+    improvementCounters.rounds[2]++;
+    while(1) {
+        switchCount = 0;
+        improvementCounters.innerRounds++;
+        improvementFor((xn + SWITCH_CHUNK - 1) / SWITCH_CHUNK, findSwitches, &Q, xn);
+        for(v = 0; v < xn; v++) {
+            if(P->choice[v] != -2) {
+                sigma[v] = P->choice[v];
+                switched[switchCount++] = v;
+            }
+        }
+        if(switchCount == 0) {
+            break;
+        }
+        improvementCounters.switches += switchCount;
+        total += switchCount;
+
+        reevaluate(S, F, switched, switchCount, finished, sigma, tau, queue, E);
+        bestResponse(S, V, F, sigma, tau, finished, predOffsets, predSources, work, inWork, switched, queue, P, E);
     }
 
-    if(p % 2 == 0) {
-        if(Val[x].L[p] < Val[y].L[p]) {
-            return 1;
+    return total;
+}
+
+/**
+ * @brief returns the vertex of P2 that choice k = i + v belongs to, see switchPolicy
+ */
+static long choiceVertex(subgame *S, uint32_t k) {
+    long low = 0, high = S->xn - 1, mid;
+
+    //S->offsets[v] + v is the first choice of v and grows with v
+    while(low < high) {
+        mid = (low + high + 1) / 2;
+        if(S->offsets[mid] + mid <= k) {
+            low = mid;
         }
-        return -1; //Val[x].L[p] > Val[y].L[p]
+        else high = mid - 1;
     }
+    return low;
+}
 
-    //p % 2 == 1
-    if(Val[x].L[p] > Val[y].L[p]) {
-        return 1;
-    }
-    return -1;
+/**
+ * @brief adds choice k to the open choices of P
+ */
+static void openChoice(switchPolicy *P, uint32_t k) {
+    P->position[k] = P->openCount;
+    P->open[P->openCount++] = k;
 }
 
+/**
+ * @brief removes the open choice at place j of P->open and returns it
+ */
+static uint32_t closeChoice(switchPolicy *P, uint32_t j) {
+    uint32_t k = P->open[j];
+    uint32_t last = P->open[--P->openCount];
+
+    P->open[j] = last;
+    P->position[last] = j;
+    P->position[k] = UINT32_MAX;
+    return k;
+}
 
 /**
- * @brief improve the strategy of the given player
- * 
- * @param C the subgraph of G with the nodes from X; C[x][0] - winner at x; C[x][1] - corresponding node in G
- * @param xn the number of nodes in X
- * @param player the player number
- * @param Val the valuation at the start of the function
- * @param sigma the strategy of P2
- * @param tau the strategy of P1
- * @param G the graph with all the parity game information; G[x][0] - owner of node x; G[x][1] - priority of x; G[x][k] > -1, k > 1, (x, G[x][k]) is an edge
- * @param M the maximum priority in G
- * @return int 1 if there was a swtich made
+ * @brief improves sigma with the random facet rule until it is the best strategy of P2
+ *
+ * The rule of Ludwig and of Matousek, Sharir and Welzl, in the form of Bjorklund and Vorobyov for parity games: if P2
+ * has no choice besides those of sigma, sigma is optimal. Otherwise a choice e of P2 that sigma does not use is removed
+ * at random, and the game without e is solved from sigma the same way. If e improves on the result, sigma switches to e
+ * and the game with e is solved again from there, otherwise the result is optimal. P1 replies to every switch with its
+ * best response. The expected number of switches is subexponential.
+ *
+ * The recursion is kept in P->facet: going down removes random choices of P->open until sigma is the only strategy
+ * left, going up puts them back in the reverse order until one of them improves. A switch then goes down again from
+ * that level. Each switch is one round of P2, and so is the last search, which finds none.
+ *
+ * @param S the subgame that is solved
+ * @param V the valuations, correct for the current strategies
+ * @param F the forest of the current strategies
+ * @param sigma the strategy of P2, it is improved
+ * @param tau the strategy of P1, a best response to sigma; it is still one at the end
+ * @param finished 1 for all vertices
+ * @param predOffsets the reversed edges of P1 in the subgame, see bestResponse
+ * @param predSources
+ * @param work scratch array of S->xn entries
+ * @param inWork scratch array of S->xn entries, all 0
+ * @param switched scratch array of S->xn entries
+ * @param queue scratch array of S->xn entries
+ * @param P the switching policy, with P->current set for sigma and room for S->offsets[S->xn] + S->xn choices in the
+ * other arrays of SWITCH_RANDOM_FACET
+ * @param E the scratch arrays of evaluateVertices
+ * @return long the number of switches of P2, 0 if sigma was already optimal
  */
-int switchEdges(long **C, long xn, int player, valuation *Val, long *sigma, long *tau, long **G, int M) {
-    long v, u, w;
-    long i;
-    int switchMade = 0; //1 if a switch has been made
-    int switchable;
-    int owner; //player that owns the vertex C[v][1]
-    int omega; //priority of vertex C[v][1]
-    for(v=0; v<xn; v++) {
-        owner = G[C[v][1]][0];
-        omega = G[C[v][1]][1];
-
-        if(owner != player) {
-            continue;
+long randomFacet(subgame *S, valuations *V, strategyForest *F, long *sigma, long *tau, int *finished,
+                 uint32_t *predOffsets, uint32_t *predSources, long *work, char *inWork, long *switched, long *queue,
+                 switchPolicy *P, evaluationGroups *E) {
+    const game *G = S->G;
+    long xn = S->xn;
+    long v, w, total = 0;
+    uint32_t depth = 0; //number of removed choices
+    uint32_t i, k;
+
+    //every choice of P2 that sigma does not use is open; choice S->offsets[v+1] of v is ending the game
+    P->openCount = 0;
+    for(v = 0; v < xn; v++) {
+        for(i = S->offsets[v]; i <= S->offsets[v+1]; i++) {
+            P->position[i + v] = UINT32_MAX;
+            if(G->owner[S->vertices[v]] == 2 && i + v != P->current[v]) {
+                openChoice(P, i + v);
+            }
         }
+    }
 
-        if(owner == 2) {
-            u = sigma[v];
+    while(1) {
+        //remove a random open choice at each level until none is left
+        while(P->openCount > 0) {
+            P->facet[depth++] = closeChoice(P, rand_r(&P->seed) % P->openCount);
         }
-        else u = tau[v];
 
-        for(i=2; C[v][i] >= 0; i++) {
-            //look through adjacent vertices for switchable edges 
-            w = C[v][i];
-            switchable = isSwitchable(Val, u, w, M);
-            if(owner == 1 && switchable == -1) {
-                //printf("Switched (%d, %d) to (%d, %d)\n", v, u, v, w);
-                //Val[u] =| Val[w] (choosing W is worse for P2)
-                switchMade = 1;
-                tau[v] = w;
-                u = w;
-            }
-            if(owner == 2 && switchable == 1) {
-                //Val[u] |= Val[w] (choosing W is better for P2)
-                switchMade = 1;
-                sigma[v] = w;
-                u = w;
+        //put the choices back until one improves on the optimal strategy of the game without it
+        v = w = -1;
+        while(depth > 0) {
+            k = P->facet[--depth];
+            v = choiceVertex(S, k);
+            i = k - v;
+            w = (i < S->offsets[v+1]) ? (long) S->targets[i] : -1;
+            if(improves(V, 2, sigma[v], w, xn)) {
+                break;
             }
+            openChoice(P, k);
+            v = -1;
         }
-
-        //P2 can also choose to simply end the game
-        if(owner == 2 && isSwitchable(Val, u, -1, M) == 1) {
-            switchMade = 1;
-            sigma[v] = -1;
+        improvementCounters.rounds[2]++;
+        if(v == -1) {
+            break;
         }
 
+        //switch to it and solve the game of this level again
+        openChoice(P, P->current[v]);
+        P->current[v] = k;
+        sigma[v] = w;
+        switched[0] = v;
+        improvementCounters.switches++;
+        total++;
+
+        reevaluate(S, F, switched, 1, finished, sigma, tau, queue, E);
+        bestResponse(S, V, F, sigma, tau, finished, predOffsets, predSources, work, inWork, switched, queue, P, E);
     }
 
-    
-    return switchMade;
+    return total;
 }
 
 /**
- * @brief determines the player with a winning positional strategy in the parity game for the nodes in C
+ * @brief determines the player with a winning positional strategy in the parity game for the vertices of S
+ *
+ * After the strategies are first evaluated, each switch only reevaluates the vertices whose play went through a
+ * switched vertex, found with the reverse of the strategies. After every switch of P2, tau is replaced with the best
+ * response of P1 to sigma.
  * 
- * @param C the subgraph of G with the nodes from X; C[x][0] - winner at x; C[x][1] - corresponding node in G
- * @param xn the number of nodes in X
- * @param M the maximum priority in C
- * @param G the graph with all the parity game information; G[x][0] - owner of node x; G[x][1] - priority of x; G[x][k] > -1, k > 1, (x, G[x][k]) is an edge
+ * @param S the subgame, its winners are filled in
+ * @param M the maximum priority in S
  */
-void pgStrategyImprovement(long **C, long xn, int M, long **G) {
-    valuation *Val = (valuation *) malloc(xn * sizeof(valuation)); //current strategy valuation
+void pgStrategyImprovement(subgame *S, int M) {
+    const game *G = S->G;
+    long xn = S->xn;
+    valuations V; //current strategy valuation
+    strategyForest F; //the reverse of the current strategies
     int *finished = (int *) malloc(xn * sizeof(int)); //finished[x] shows if val[x] has been calculated with the current strategies
+    long *switched = (long *) malloc(xn * sizeof(long)); //the vertices changed by the last switch
+    long *queue = (long *) malloc(xn * sizeof(long)); //scratch array of reevaluate
     long i;
-    int switchSigma; //1 if there was a change in the strategy of P2
-    int switchTau; //1 if there was a change in the strategy of P1
-
-
-    for(i=0; i<xn; i++) {
-        Val[i].L = (long *) malloc((M+1) * sizeof(long));
+    long switchSigma; //number of changes in the strategy of P2
+    uint32_t *predOffsets = (uint32_t *) calloc(xn + 1, sizeof(uint32_t)); //the reversed edges of P1 in the subgame
+    uint32_t *predSources = (uint32_t *) malloc((S->offsets[xn] + 1) * sizeof(uint32_t));
+    long *work = (long *) malloc(xn * sizeof(long)); //scratch arrays of bestResponse
+    char *inWork = (char *) calloc(xn + 1, sizeof(char));
+    switchPolicy P = {options.switchPolicy, 1, NULL, NULL, (long *) malloc(xn * sizeof(long)), NULL, NULL, NULL, NULL,
+                      NULL, NULL, 0, NULL};
+    evaluationGroups E; //the state of evaluateVertices
+    int threads = (options.threads > 1 && xn >= options.improvementThreshold) ? options.threads : 1;
+    verify_alloc(finished);
+    verify_alloc(P.choice);
+    verify_alloc(switched);
+    verify_alloc(queue);
+    verify_alloc(predOffsets);
+    verify_alloc(predSources);
+    verify_alloc(work);
+    verify_alloc(inWork);
+
+
+    newValuations(&V, xn, M);
+
+    E.path = (long **) malloc(threads * sizeof(long *));
+    verify_alloc(E.path);
+    for(int t = 0; t < threads; t++) {
+        E.path[t] = (long *) malloc(xn * sizeof(long));
+        verify_alloc(E.path[t]);
+    }
+    E.parent = E.index = E.groupStart = E.order = NULL; //only used with several threads
+    if(threads > 1) {
+        E.parent = (long *) malloc(xn * sizeof(long));
+        E.index = (long *) malloc(xn * sizeof(long));
+        E.groupStart = (long *) malloc((xn + 1) * sizeof(long));
+        E.order = (long *) malloc(xn * sizeof(long));
+        verify_alloc(E.parent);
+        verify_alloc(E.index);
+        verify_alloc(E.groupStart);
+        verify_alloc(E.order);
     }
 
     long *sigma = (long *) malloc(xn * sizeof(long)); //strategy of P2
@@ -323,120 +1033,196 @@ void pgStrategyImprovement(long **C, long xn, int M, long **G) {
     //initialize tau
     long *tau = (long *) malloc(xn * sizeof(long)); //strategy of P1 
     for(i = 0; i < xn; i++) {
-        if(G[C[i][1]][0] == 1) {
-            tau[i] = C[i][2];
+        if(G->owner[S->vertices[i]] == 1 && S->offsets[i] < S->offsets[i+1]) {
+            tau[i] = S->targets[S->offsets[i]];
         }
         else tau[i] = -1;
     }
 
+    E.S = S;
+    E.V = &V;
+    E.finished = finished;
+    E.sigma = sigma;
+    E.tau = tau;
 
-    do {
-        do {
-            
-            //Calculate Val[i] for all vertices
-            for(i = 0; i<xn; i++) {
-                finished[i] = -1;
-            }
-            
-            for(i = 0; i<xn; i++) {
-                evaluate(Val, finished, i, sigma, tau, C, xn, G, M);
-                
-            }
+    //Calculate V[i] for all vertices
+    for(i = 0; i<xn; i++) {
+        finished[i] = -1;
+        queue[i] = i;
+    }
+    evaluateVertices(&E, queue, xn);
+    newStrategyForest(&F, S, sigma, tau);
+    improvementCounters.evaluations += xn;
 
-            switchTau = switchEdges(C, xn, 1, Val, sigma, tau, G, M); //improve tau strategy
+    //the edges of P1 reversed for bestResponse
+    //predOffsets[w+1] counts the edges into w first, then becomes the position after the last of them
+    for(i = 0; i < xn; i++) {
+        if(G->owner[S->vertices[i]] != 1) {
+            continue;
+        }
+        for(uint32_t e = S->offsets[i]; e < S->offsets[i+1]; e++) {
+            predOffsets[S->targets[e] + 1]++;
+        }
+    }
+    for(i = 0; i < xn; i++) {
+        predOffsets[i+1] += predOffsets[i];
+    }
+    for(i = 0; i < xn; i++) {
+        if(G->owner[S->vertices[i]] != 1) {
+            continue;
+        }
+        for(uint32_t e = S->offsets[i]; e < S->offsets[i+1]; e++) {
+            predSources[predOffsets[S->targets[e]]++] = i;
+        }
+    }
+    for(i = xn; i > 0; i--) {
+        predOffsets[i] = predOffsets[i-1];
+    }
+    predOffsets[0] = 0;
 
-        }while(switchTau == 1); 
-        //no odd-switchable edges left
+    if(P.policy == SWITCH_RESTRICTED_BEST) {
+        P.allowed = (uint8_t *) malloc((S->offsets[xn] + xn + 1) * sizeof(uint8_t));
+        verify_alloc(P.allowed);
+    }
+    if(P.policy == SWITCH_SINGLE_BEST || P.policy == SWITCH_RANDOM_EDGE || P.policy == SWITCH_RANDOM_ORDER) {
+        long chunks = (xn + SWITCH_CHUNK - 1) / SWITCH_CHUNK;
+        P.chunkVertex = (long *) malloc((chunks + 1) * sizeof(long));
+        P.chunkChoice = (long *) malloc((chunks + 1) * sizeof(long));
+        P.chunkCandidates = (long *) malloc((chunks + 1) * sizeof(long));
+        verify_alloc(P.chunkVertex);
+        verify_alloc(P.chunkChoice);
+        verify_alloc(P.chunkCandidates);
+    }
+    if(P.policy == SWITCH_RANDOM_FACET) {
+        //sigma starts by ending the game at every vertex
+        uint32_t choices = S->offsets[xn] + xn;
+        P.current = (uint32_t *) malloc((xn + 1) * sizeof(uint32_t));
+        P.open = (uint32_t *) malloc((choices + 1) * sizeof(uint32_t));
+        P.position = (uint32_t *) malloc((choices + 1) * sizeof(uint32_t));
+        P.facet = (uint32_t *) malloc((choices + 1) * sizeof(uint32_t));
+        verify_alloc(P.current);
+        verify_alloc(P.open);
+        verify_alloc(P.position);
+        verify_alloc(P.facet);
+        for(i = 0; i < xn; i++) {
+            P.current[i] = S->offsets[i+1] + i;
+        }
+    }
+    if(P.policy == SWITCH_RANDOM_ORDER) {
+        //a random order of all choices, one per edge and one for ending the game at each vertex
+        uint32_t choices = S->offsets[xn] + xn;
+        uint32_t j, swap;
+        P.rank = (uint32_t *) malloc((choices + 1) * sizeof(uint32_t));
+        verify_alloc(P.rank);
+        for(j = 0; j < choices; j++) {
+            P.rank[j] = j;
+        }
+        for(j = choices; j > 1; j--) {
+            uint32_t r = rand_r(&P.seed) % j;
+            swap = P.rank[j-1];
+            P.rank[j-1] = P.rank[r];
+            P.rank[r] = swap;
+        }
+    }
 
-        switchSigma = switchEdges(C, xn, 2, Val, sigma, tau, G, M); //improve sigma strategy
+    do {
+        //improve tau until no odd-switchable edges are left
+        bestResponse(S, &V, &F, sigma, tau, finished, predOffsets, predSources, work, inWork, switched, queue, &P, &E);
+
+        if(P.policy == SWITCH_RESTRICTED_BEST) {
+            switchSigma = restrictedImprovement(S, &V, &F, sigma, tau, finished, predOffsets, predSources, work,
+                                                inWork, switched, queue, &P, &E);
+        }
+        else if(P.policy == SWITCH_RANDOM_FACET) {
+            switchSigma = randomFacet(S, &V, &F, sigma, tau, finished, predOffsets, predSources, work, inWork,
+                                      switched, queue, &P, &E);
+        }
+        else {
+            switchSigma = switchEdges(S, 2, &V, sigma, tau, &P, switched); //improve sigma strategy
+            reevaluate(S, &F, switched, switchSigma, finished, sigma, tau, queue, &E);
+        }
 
 
-    }while(switchSigma == 1);
+    }while(switchSigma > 0);
     //no switchable edges left
 
     //determine the winners of each vertex
     for(i = 0; i<xn; i++) {
-        if(Val[i].infinite == 2) {
-            C[i][0] = 2;
+        if(V.infinite[i] == 2) {
+            S->winner[i] = 2;
         }
         else{
-            C[i][0] = 1;
+            S->winner[i] = 1;
         } 
-
-        free(Val[i].L);
     }
 
-    free(Val);
+    freeValuations(&V);
+    freeStrategyForest(&F);
     free(finished);
+    for(int t = 0; t < threads; t++) {
+        free(E.path[t]);
+    }
+    free(E.path);
+    free(E.parent);
+    free(E.index);
+    free(E.groupStart);
+    free(E.order);
+    free(switched);
+    free(queue);
+    free(predOffsets);
+    free(predSources);
+    free(work);
+    free(inWork);
     free(sigma);
     free(tau);
+    free(P.rank);
+    free(P.allowed);
+    free(P.current);
+    free(P.open);
+    free(P.position);
+    free(P.facet);
+    free(P.choice);
+    free(P.chunkVertex);
+    free(P.chunkChoice);
+    free(P.chunkCandidates);
 
 }
 
 /**
  * @brief Solves the parity game using just the strategy improvement algorithm
  * 
- * @param G the graph with all the parity game information; G[x][0] - owner of node x; G[x][1] - priority of x; G[x][k] > -1, k > 1, (x, G[x][k]) is an edge 
- * @param n number of nodes in the graph
+ * @param G the game
  * @return int* W[x] - the player that has a winning positional strategy at node x
  */
-int *pgSolver3(long **G, long n) {
-    long xn = n;
-    long **C; //the subgraph of G with the nodes from X; C[x][0] - winner at x; C[x][1] - corresponding node in G
-    long size; //allocated size of a row in G
-    long i, j;
-    int M=-1; //maximum priority in the graph
+int *pgSolver3(const game *G) {
+    long n = G->n;
+    subgame S; //the whole game, seen as a subgame
+    long *X = (long *) malloc((n+1) * sizeof(long)); //all vertices of G
+    long *local = (long *) malloc((n+1) * sizeof(long)); //local[v] - position of v in X
+    long i;
+    int M = maxOmega(G); //maximum priority in the graph
     int *W; //W[x] - the player that has a winning strategy at vertex x
-
-
-    C = (long **) malloc (n * sizeof(long *)); //the subgraph C will contain the whole graph G
+    verify_alloc(X);
+    verify_alloc(local);
 
     for(i = 0; i<n; i++) {
-        size = n/10 + 2;
-        C[i] = (long *) malloc(size * sizeof(long));
-        verify_alloc(C);
-
-        if(G[i][1] > M) {
-            M = G[i][1];
-        }
-
-        C[i][0] = 0;
-        C[i][1] = i;
-
-        //Add all edges to C
-        j = 2;
-        while(G[i][j] != -2) {
-            if(j == size) {
-                //increase size of C[i]
-                size = size * 2;
-                C[i] = (long *) realloc(C[i], size * sizeof(long));
-                verify_alloc(C);
-            }
-            C[i][j] = G[i][j];
-            j++;
-        }
-        if(j == size) {
-            //increase size of C[i]
-            size = size * 2;
-            C[i] = (long *) realloc(C[i], size * sizeof(long));
-            verify_alloc(C);
-        }
-        C[i][j] = -2;
-
+        X[i] = i;
+        local[i] = -1;
     }
+    X[n] = -2;
+    copySubgame(&S, X, G, local);
 
-
-
-    pgStrategyImprovement(C, xn, M, G);
+    pgStrategyImprovement(&S, M);
 
     //store the winners 
     W = (int *) malloc(n * sizeof(int));
     for(i=0; i<n; i++) {
-        W[i] = C[i][0];
-        free(C[i]);
+        W[i] = S.winner[i];
     }
 
-    free(C);
+    freeSubgame(&S);
+    free(X);
+    free(local);
 
     return W;
 }
\ No newline at end of file
@@ -1,12 +1,135 @@
 #ifndef STRATEGYIMPROVEMENT_H_INCLUDED
 #define STRATEGYIMPROVEMENT_H_INCLUDED
 
-typedef struct valuation {
-    int infinite;
-    long *L;
-} valuation;
+#include "graphFunctions.h"
 
-void pgStrategyImprovement(long **C, long xn, int M, long **G);
-int *pgSolver3(long **G, long n);
+typedef unsigned __int128 valuationKey; //the counts of a valuation packed into one number, see valuations
 
-#endif
\ No newline at end of file
+/**
+ * @brief the valuations of all vertices of a subgame, stored in one block that is allocated once per solve
+ *
+ * The valuation of vertex v is infinite[v] (0 for a finite play, otherwise the player that wins the cycle) and, for a
+ * finite play, how many times each priority occurs on it. Entry xn is the valuation of the empty play, which is used
+ * when P2 ends the game. top[v] is the largest priority that occurs on the play, -1 if none.
+ * If all counts fit in a valuationKey, width bits per priority, the counts are only stored packed in key[v]: the count
+ * of an even priority p as it is, the count of an odd one as 2^width - 1 - count, with priority M in the highest bits.
+ * A larger key is then better for P2, and two valuations are compared in O(1). Otherwise the counts are stored in
+ * L[v * (M+1) + p], and comparisons start at the top priorities.
+ */
+typedef struct valuations {
+    int M; //the maximum priority in the subgame
+    int packed; //1 if the counts are stored in key, 0 if in L
+    int width; //number of bits of each priority in key
+    uint8_t *infinite; //infinite[v] - 0 if the play from v is finite, else the player that wins its cycle
+    int32_t *top; //top[v] - the largest priority on the finite play from v, -1 if none
+    valuationKey *key; //key[v] - the packed counts, if packed
+    uint32_t *L; //L[v * (M+1) + p] - the number of times p occurs on the finite play from v, if not packed
+    void *arena; //the memory of all the arrays
+} valuations;
+
+/**
+ * @brief the reverse of the graph of the two strategies, as linked lists of children. Vertex xn stands for the empty
+ * play, so the parent of the last vertex of a finite play is xn
+ */
+typedef struct strategyForest {
+    long xn; //number of vertices in the subgame
+    long *parent; //parent[v] - the next vertex of the play from v, xn for the empty play
+    long *firstChild; //firstChild[w] - a vertex whose parent is w, -1 if none
+    long *nextSibling; //nextSibling[v], prevSibling[v] - the other children of the parent of v, -1 at the ends
+    long *prevSibling;
+} strategyForest;
+
+/**
+ * @brief the switching policy of a strategy improvement solve, see switchEdges
+ */
+typedef struct switchPolicy {
+    int policy; //one of the SWITCH_ values of options.switchPolicy
+    unsigned int seed; //state of rand_r for the random policies
+    uint32_t *rank; //SWITCH_RANDOM_ORDER: rank[i + v] - the position of choice i of vertex v in a random order
+    uint8_t *allowed; //SWITCH_RESTRICTED_BEST: allowed[i + v] - 1 if choice i of vertex v may be used by the improvement
+    long *choice; //scratch array of S->xn entries for the switches found by findSwitches
+    long *chunkVertex; //single switch policies: chunkVertex[c] - the vertex of the switch found in chunk c, -1 if none
+    long *chunkChoice; //single switch policies: chunkChoice[c] - the index i + v of the choice of that switch
+    long *chunkCandidates; //SWITCH_RANDOM_EDGE: chunkCandidates[c] - the number of improving choices in chunk c
+    uint32_t *current; //SWITCH_RANDOM_FACET: current[v] - the index i + v of the choice of sigma at vertex v of P2
+    uint32_t *open; //SWITCH_RANDOM_FACET: the choices of P2 that are neither removed nor used by sigma
+    uint32_t *position; //SWITCH_RANDOM_FACET: position[i + v] - the place of choice i of v in open, UINT32_MAX if none
+    uint32_t openCount; //number of choices in open
+    uint32_t *facet; //SWITCH_RANDOM_FACET: the removed choices, one per level of the recursion
+} switchPolicy;
+
+#define SWITCH_CHUNK 1024 //number of vertices a thread examines at a time in findSwitches
+
+/**
+ * @brief the state of a search for switches, shared by the threads of switchEdges and bestResponse
+ */
+typedef struct switchSearch {
+    subgame *S; //the subgame that is solved
+    valuations *V; //the current valuations
+    int player; //the player whose strategy is improved
+    int first; //1 if a vertex takes its first improving choice, 0 if its best one
+    long *sigma; //the strategy of P2
+    long *tau; //the strategy of P1
+    long *vertices; //the examined vertices, 0 to count - 1 if NULL
+    long count; //number of examined vertices
+    long *choice; //choice[j] - the new next vertex of the j-th examined vertex, -2 if it keeps its strategy
+    uint8_t *allowed; //allowed[i + v] - 0 if choice i of vertex v may not be taken; every choice may be taken if NULL
+    switchPolicy *P; //the policy of findSingleSwitch, NULL for findSwitches
+} switchSearch;
+
+/**
+ * @brief the scratch arrays of evaluateVertices. With several threads, the vertices to evaluate are split into groups
+ * that are connected by the strategies, and every group is evaluated by one thread
+ */
+typedef struct evaluationGroups {
+    subgame *S; //the subgame that is solved
+    valuations *V; //the valuations
+    int *finished; //see evaluate
+    long *sigma; //the strategy of P2
+    long *tau; //the strategy of P1
+    long **path; //path[t] - scratch array of evaluate for thread t
+    long *parent; //union-find forest of the vertices to evaluate, the root of a tree names its group
+    long *index; //index[r] - the number of the group with root r
+    long *groupStart; //the vertices of group g are order[groupStart[g]], ..., order[groupStart[g+1] - 1]
+    long *order;
+} evaluationGroups;
+
+/**
+ * @brief counts of the work done by strategy improvement, added up over all solves until they are reset
+ */
+typedef struct improvementStats {
+    long rounds[3]; //rounds[p] - number of times player p tried to improve its strategy
+    long innerRounds; //number of rounds of switches of P2 inside the restricted games of SWITCH_RESTRICTED_BEST
+    long switches; //number of vertices whose strategy was switched
+    long evaluations; //number of valuations that were computed
+} improvementStats;
+
+extern improvementStats improvementCounters;
+
+void newValuations(valuations *V, long xn, int M);
+void freeValuations(valuations *V);
+void evaluate(valuations *V, int *finished, long v, long *sigma, long *tau, subgame *S, long *path);
+int isSwitchable(valuations *V, long x, long y, long xn);
+void findSwitches(long chunk, int thread, void *arg);
+void findSingleSwitch(long chunk, int thread, void *arg);
+long switchEdges(subgame *S, int player, valuations *V, long *sigma, long *tau, switchPolicy *P, long *switched);
+void evaluateGroup(long g, int thread, void *arg);
+void evaluateVertices(evaluationGroups *E, long *vertices, long count);
+void newStrategyForest(strategyForest *F, subgame *S, long *sigma, long *tau);
+void freeStrategyForest(strategyForest *F);
+void moveVertex(strategyForest *F, long v, long w);
+long reevaluate(subgame *S, strategyForest *F, long *switched, long count, int *finished, long *sigma, long *tau,
+                long *queue, evaluationGroups *E);
+long bestResponse(subgame *S, valuations *V, strategyForest *F, long *sigma, long *tau, int *finished,
+                  uint32_t *predOffsets, uint32_t *predSources, long *work, char *inWork, long *switched, long *queue,
+                  switchPolicy *P, evaluationGroups *E);
+long restrictedImprovement(subgame *S, valuations *V, strategyForest *F, long *sigma, long *tau, int *finished,
+                           uint32_t *predOffsets, uint32_t *predSources, long *work, char *inWork, long *switched,
+                           long *queue, switchPolicy *P, evaluationGroups *E);
+long randomFacet(subgame *S, valuations *V, strategyForest *F, long *sigma, long *tau, int *finished,
+                 uint32_t *predOffsets, uint32_t *predSources, long *work, char *inWork, long *switched, long *queue,
+                 switchPolicy *P, evaluationGroups *E);
+void pgStrategyImprovement(subgame *S, int M);
+int *pgSolver3(const game *G);
+
+#endif
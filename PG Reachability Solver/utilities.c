@@ -1,5 +1,16 @@
 #include "utilities.h"
 
+solverOptions options = {
+    .threads = 1,
+    .parallelScc = 0,
+    .sccThreshold = 100000,
+    .adaptiveK = 0,
+    .mpgBackend = MPG_VALUE_ITERATION,
+    .sweepThreshold = 4096,
+    .switchPolicy = SWITCH_ALL_BEST,
+    .improvementThreshold = 4096
+};
+
 
 
 
@@ -15,31 +26,18 @@ void verify_alloc(void *p) {
     }
 } 
 
-/**
- * @brief frees a 2D array
- * 
- * @param n - number of rows in G
- * @param G - the 2D array
- */
-void freeGraph(long n, long **G) {
-    for(long i = 0; i < n; i++) {
-        free(G[i]);
-    }
-    free(G);
-}
-
 /**
  * @brief returns -1 for a vertex owned by player 1, returns 1 otherwise
  * 
- * @param G - the graph; G[v][0] represents the owner of v
+ * @param G - the game; G->owner[v] represents the owner of v
  * @param i - the vertex in question
  * @return int - 1 or -1
  */
-int epsilon(long **G, long i) {
-    if(G[i][0] == 2) {
+int epsilon(const game *G, long i) {
+    if(G->owner[i] == 2) {
         return 1;
     }
-    else if(G[i][0] == 1) {
+    else if(G->owner[i] == 1) {
         return -1;
         }
         else return 0;
@@ -48,18 +46,15 @@ int epsilon(long **G, long i) {
 /**
  * @brief determines the maximum Omega value in the graph
  * 
- * @param G - the graph; G[v][1] = omega(v), 
- * @param n - number of vertices
+ * @param G - the game; G->priority[v] = omega(v)
  * @return int - the maximum Omega value
  */
-int maxOmega(long **G, long n) {
-    unsigned int max = G[0][1];
-    int maxIndex = 0;
-
-    for(long i=1; i < n; i++) {
-        if(G[i][1] > max) {
-            max = G[i][1];
-            maxIndex = i; 
+int maxOmega(const game *G) {
+    unsigned int max = 0;
+
+    for(long i=0; i < G->n; i++) {
+        if(G->priority[i] > max) {
+            max = G->priority[i];
         }
     }
     return max;
@@ -98,42 +93,152 @@ long long modulus(long long x) {
 }
 
 /**
- * @brief returns an exact copy of the graph G
+ * @brief returns 1 if the name ends with the given suffix
  * 
- * @param G the graph
- * @param n number of nodes
- * @return long** an exact copy of the graph G
+ * @param name 
+ * @param suffix 
+ * @return int 
+ */
+int hasSuffix(char *name, char *suffix) {
+    size_t nameLength = strlen(name);
+    size_t suffixLength = strlen(suffix);
+
+    return nameLength >= suffixLength && strcmp(name + nameLength - suffixLength, suffix) == 0;
+}
+
+static threadPool pool = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER,
+    PTHREAD_MUTEX_INITIALIZER, NULL, 0, NULL, 0, 0, 0};
+
+/**
+ * @brief takes steps of the loop until none are left
+ *
+ * @param L the loop
+ * @param thread the number of the thread, from 0 to options.threads - 1
+ */
+static void runLoop(parallelLoop *L, int thread) {
+    long i;
+
+    while((i = __atomic_fetch_add(&L->next, 1, __ATOMIC_RELAXED)) < L->count) {
+        L->body(i, thread, L->arg);
+    }
+}
+
+/**
+ * @brief a thread of the pool: waits for a loop, takes part in it and waits for the next one
+ *
+ * @param arg the number of the thread, from 1 to the size of the pool
+ * @return void* NULL
  */
-long **duplicateGraph(long **G, long n) {
-    long i, j;
-    long size;
-    long **C = (long **) malloc (n * sizeof(long *)); //the subgraph C will contain the whole graph G
-
-    for(i = 0; i<n; i++) {
-        size = 20;
-        C[i] = (long *) malloc(size * sizeof(long));
-        verify_alloc(C);
-
-        j=0;
-        while(G[i][j] != -2) {
-            if(j == size) {
-                //increase size of C[i]
-                size = size * 2;
-                C[i] = (long *) realloc(C[i], size * sizeof(long));
-                verify_alloc(C);
-            }
-            C[i][j] = G[i][j];
-            j++;
+static void *poolWorker(void *arg) {
+    int thread = (int) (long) arg;
+    unsigned long seen = 0; //the last loop this thread took part in
+    parallelLoop *L;
+
+    while(1) {
+        pthread_mutex_lock(&pool.lock);
+        while(pool.generation == seen && !pool.stop) {
+            pthread_cond_wait(&pool.posted, &pool.lock);
+        }
+        if(pool.stop) {
+            pthread_mutex_unlock(&pool.lock);
+            return NULL;
         }
-        if(j == size) {
-            //increase size of C[i]
-            size = size + 1;
-            C[i] = (long *) realloc(C[i], size * sizeof(long));
-            verify_alloc(C);
+        seen = pool.generation;
+        L = pool.loop;
+        pthread_mutex_unlock(&pool.lock);
+
+        runLoop(L, thread);
+
+        pthread_mutex_lock(&pool.lock);
+        pool.busy--;
+        if(pool.busy == 0) {
+            pthread_cond_signal(&pool.finished);
         }
-        C[i][j] = -2;
+        pthread_mutex_unlock(&pool.lock);
+    }
+}
+
+/**
+ * @brief stops and joins the threads of the pool. The next parallel loop starts them again
+ */
+void stopThreadPool(void) {
+    pthread_mutex_lock(&pool.lock);
+    pool.stop = 1;
+    pthread_cond_broadcast(&pool.posted);
+    pthread_mutex_unlock(&pool.lock);
+
+    for(int t = 0; t < pool.size; t++) {
+        pthread_join(pool.workers[t], NULL);
+    }
+    free(pool.workers);
+    pool.workers = NULL;
+    pool.size = 0;
+    pool.stop = 0;
+    pool.generation = 0; //new threads start waiting for the first loop
+}
+
+/**
+ * @brief makes sure the pool has the given number of threads, restarting it if options.threads changed
+ *
+ * @param size number of threads besides the one that calls parallelFor
+ */
+static void startThreadPool(int size) {
+    static int registered = 0;
+
+    if(pool.size == size) {
+        return;
+    }
+    if(pool.size > 0) {
+        stopThreadPool();
+    }
+    if(!registered) {
+        atexit(stopThreadPool);
+        registered = 1;
+    }
+
+    pool.workers = (pthread_t *) malloc(size * sizeof(pthread_t));
+    verify_alloc(pool.workers);
+    for(int t = 0; t < size; t++) {
+        pthread_create(&pool.workers[t], NULL, poolWorker, (void *) (long) (t + 1));
+    }
+    pool.size = size;
+}
+
+/**
+ * @brief calls body(i, thread, arg) for i = 0, ..., count-1 on options.threads threads: the calling thread and the
+ * threads of the pool. Every thread takes the next step as soon as it is done with the previous one, so the steps may
+ * take very different times. A loop started from inside another one, or while another thread uses the pool, runs on
+ * the calling thread alone
+ *
+ * @param count number of steps
+ * @param body the function called for every step; the steps of one thread are never run at the same time
+ * @param arg passed to body
+ */
+void parallelFor(long count, loopBody body, void *arg) {
+    int threads = options.threads;
+    parallelLoop L = {count, 0, body, arg};
+
+    if(threads <= 1 || count <= 1 || pthread_mutex_trylock(&pool.inUse) != 0) {
+        runLoop(&L, 0);
+        return;
+    }
+
+    startThreadPool(threads - 1);
+
+    pthread_mutex_lock(&pool.lock);
+    pool.loop = &L;
+    pool.busy = pool.size;
+    pool.generation++;
+    pthread_cond_broadcast(&pool.posted);
+    pthread_mutex_unlock(&pool.lock);
+
+    runLoop(&L, 0);
 
+    pthread_mutex_lock(&pool.lock);
+    while(pool.busy > 0) {
+        pthread_cond_wait(&pool.finished, &pool.lock);
     }
+    pthread_mutex_unlock(&pool.lock);
 
-    return C;
+    pthread_mutex_unlock(&pool.inUse);
 }
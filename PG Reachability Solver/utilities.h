@@ -9,20 +9,83 @@
 #include <limits.h>
 #include <unistd.h>
 #include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <getopt.h>
+#include <pthread.h>
 
 
 #include "xlsxwriter.h"
 //Copyright 2014-2022, John McNamara <jmcnamara@cpan.org>
 //All rights reserved.
 
+#include "parityGame.h"
+
+/**
+ * @brief settings shared by all solvers, set from the command line in main
+ */
+typedef struct solverOptions {
+    int threads; //number of threads the parallel parts of the solvers may use
+    int parallelScc; //1 if large subsets are split into strongly connected components in parallel
+    long sccThreshold; //subsets with fewer vertices are always split sequentially
+    long adaptiveK; //if positive, the search for obsolete edges starts with cycles of this length instead of n
+    int mpgBackend; //the algorithm pgSolver1 uses on the mean payoff subgames, MPG_VALUE_ITERATION or MPG_ENERGY
+    long sweepThreshold; //the rounds of the value iteration on subgames with fewer vertices run on a single thread
+    int switchPolicy; //which improving edges strategy improvement switches, one of the SWITCH_ values
+    long improvementThreshold; //strategy improvement on subgames with fewer vertices runs on a single thread
+} solverOptions;
+
+#define MPG_VALUE_ITERATION 0 //k-step value iteration, mpgSubgraphSolver
+#define MPG_ENERGY 1 //small energy progress measures, mpgEnergySolver
+
+#define SWITCH_ALL_BEST 0 //every vertex with an improving edge switches to its best edge
+#define SWITCH_ALL_FIRST 1 //every vertex with an improving edge switches to the first one
+#define SWITCH_SINGLE_BEST 2 //only the improving edge to the best valuation of all is switched
+#define SWITCH_RANDOM_EDGE 3 //only one improving edge, chosen at random, is switched
+#define SWITCH_RANDOM_ORDER 4 //only the improving edge that comes first in a random order of the edges is switched
+#define SWITCH_RESTRICTED_BEST 5 //P2 switches to the best strategy that only uses its current and improving edges
+#define SWITCH_RANDOM_FACET 6 //the random facet rule: P2 solves the game without a random edge first, recursively
+
+extern solverOptions options;
+
+typedef void (*loopBody)(long i, int thread, void *arg); //one step of a loop run by parallelFor
+
+/**
+ * @brief the state of a loop whose steps are shared by several threads
+ */
+typedef struct parallelLoop {
+    long count; //number of steps
+    long next; //the first step that has not been taken by a thread
+    loopBody body; //the function called for every step
+    void *arg; //passed to body
+} parallelLoop;
+
+/**
+ * @brief the threads that run the loops of parallelFor. They are started by the first parallel loop and wait for the
+ * next one in between, so a loop does not pay for creating threads
+ */
+typedef struct threadPool {
+    pthread_mutex_t lock; //protects everything below
+    pthread_cond_t posted; //signalled when a loop is posted or the threads have to stop
+    pthread_cond_t finished; //signalled when the last thread is done with the loop
+    pthread_mutex_t inUse; //held by the thread that runs a loop on the pool
+    pthread_t *workers; //the threads
+    int size; //number of threads; the thread that calls parallelFor takes part as well
+    parallelLoop *loop; //the loop that was posted last
+    unsigned long generation; //number of loops posted so far
+    int busy; //number of threads that are not done with the loop yet
+    int stop; //1 if the threads have to stop
+} threadPool;
 
 void verify_alloc(void *p);
-void freeGraph(long n, long **G);
-long **duplicateGraph(long **G, long n) ;
 
-int epsilon(long **G, long i);
-int maxOmega(long **G, long n); 
+int epsilon(const game *G, long i);
+int maxOmega(const game *G);
 long long power(long long a, long b);
 long long modulus (long long x);
+int hasSuffix(char *name, char *suffix);
+void parallelFor(long count, loopBody body, void *arg);
+void stopThreadPool(void);
 
 #endif